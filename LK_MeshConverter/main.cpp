@@ -0,0 +1,165 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+using namespace Loukoum;
+
+//LODs : grid cells of extent / 128, / 64 ... / 4
+constexpr size_t LOD_COUNT = 4;
+constexpr float LOD_FIRST_GRID = 128.0f;
+constexpr float LOD_LAST_GRID = 4.0f;
+
+/// <summary>
+/// Read an OBJ index, negative indices are relative to the end
+/// </summary>
+/// <param name="token">Face token like 3, 3/1 or 3/1/2</param>
+/// <param name="positionCount">Positions read so far</param>
+/// <returns>Zero based position index</returns>
+static size_t readObjIndex(const std::string& token, size_t positionCount)
+{
+	long index = std::stol(token.substr(0, token.find('/')));
+	size_t result = index < 0 ? positionCount + index : (size_t)index - 1;
+	if (result >= positionCount)
+		throw std::runtime_error("Failed to read OBJ : face index out of range");
+	return result;
+}
+
+/// <summary>
+/// Load an OBJ file : positions, optional vertex colors ("v x y z r g b"), polygon faces
+/// </summary>
+/// <param name="filename">OBJ file</param>
+/// <param name="vertices">Welded vertices</param>
+/// <param name="indices">Triangle list indices</param>
+static void loadObj(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::ifstream file(filename);
+	if (!file.is_open())
+		throw std::runtime_error("Failed to open " + filename);
+
+	std::vector<Vertex> objVertices;
+	std::unordered_map<Vertex, uint32_t, VertexHash> lookup;
+	std::vector<uint32_t> polygon;
+	std::string line;
+
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string type;
+		stream >> type;
+
+		if (type == "v") {
+			//Position and color, white when missing
+			Vertex vertex{ glm::vec3(0.0f), glm::vec4(1.0f) };
+			stream >> vertex.pos.x >> vertex.pos.y >> vertex.pos.z;
+			float r, g, b;
+			if (stream >> r >> g >> b)
+				vertex.color = glm::vec4(r, g, b, 1.0f);
+			objVertices.push_back(vertex);
+		}
+		else if (type == "f") {
+			//Welded corners, polygon split in a fan
+			polygon.clear();
+			std::string token;
+			while (stream >> token) {
+				const Vertex& vertex = objVertices[readObjIndex(token, objVertices.size())];
+				auto it = lookup.emplace(vertex, static_cast<uint32_t>(vertices.size()));
+				if (it.second)
+					vertices.push_back(vertex);
+				polygon.push_back(it.first->second);
+			}
+			for (size_t i = 2; i < polygon.size(); i++) {
+				indices.push_back(polygon[0]);
+				indices.push_back(polygon[i - 1]);
+				indices.push_back(polygon[i]);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Read vertex format name
+/// </summary>
+/// <param name="name">float, half or snorm16</param>
+/// <returns></returns>
+static int readFormat(const std::string& name)
+{
+	if (name == "float")
+		return VERTEX_FORMAT_FLOAT;
+	if (name == "half")
+		return VERTEX_FORMAT_HALF;
+	if (name == "snorm16")
+		return VERTEX_FORMAT_SNORM16;
+	throw std::runtime_error("Unknown vertex format " + name);
+}
+
+/// <summary>
+/// Mesh converter : OBJ to Loukoum mesh file
+/// Usage : LK_MeshConverter input.obj output.lkm [float|half|snorm16]
+/// </summary>
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		std::cout << "Usage : LK_MeshConverter input.obj output.lkm [float|half|snorm16]" << std::endl;
+		return 1;
+	}
+
+	try {
+		int format = argc > 3 ? readFormat(argv[3]) : VERTEX_FORMAT_FLOAT;
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		loadObj(argv[1], vertices, indices);
+		if (indices.empty())
+			throw std::runtime_error("Failed to convert : no triangle");
+
+		//Finest LOD : full optimization, the vertex stream follows its order
+		MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+		MeshOptimizer::optimizeOverdraw(indices, vertices);
+		MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+		std::vector<MeshFileLod> lods;
+		lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f, 0 });
+		std::vector<uint32_t> indexStream = indices;
+
+		//Coarser LODs reuse the vertex stream
+		VertexBounds extentBounds = VertexFormat::computeBounds(vertices, VERTEX_FORMAT_SNORM16);
+		float extent = 2.0f * glm::max(extentBounds.scale.x, glm::max(extentBounds.scale.y, extentBounds.scale.z));
+		for (float grid = LOD_FIRST_GRID; grid >= LOD_LAST_GRID && lods.size() < LOD_COUNT; grid /= 2.0f) {
+			float cellSize = extent / grid;
+			std::vector<uint32_t> lodIndices = MeshOptimizer::simplifyClustering(indices, vertices, cellSize);
+
+			//Keep grids removing at least 10% of the previous LOD triangles
+			if (lodIndices.empty() || lodIndices.size() > lods.back().indexCount * 9 / 10)
+				continue;
+
+			MeshOptimizer::optimizeVertexCache(lodIndices, vertices.size());
+			lods.push_back({ static_cast<uint32_t>(indexStream.size()), static_cast<uint32_t>(lodIndices.size()), cellSize, 0 });
+			indexStream.insert(indexStream.end(), lodIndices.begin(), lodIndices.end());
+		}
+
+		//Vertex stream in the requested format
+		VertexBounds bounds = VertexFormat::computeBounds(vertices, format);
+		if (format == VERTEX_FORMAT_FLOAT) {
+			MeshFile::write(argv[2], format, bounds, vertices.data(), vertices.size(), indexStream, lods);
+		}
+		else {
+			std::vector<PackedVertex> packed = VertexFormat::pack(vertices, indices, format, bounds);
+			MeshFile::write(argv[2], format, bounds, packed.data(), packed.size(), indexStream, lods);
+		}
+
+		std::cout << argv[2] << " : " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles, " << lods.size() << " LODs" << std::endl;
+		for (size_t lod = 0; lod < lods.size(); lod++)
+			std::cout << "  LOD " << lod << " : " << lods[lod].indexCount / 3 << " triangles, error " << lods[lod].error << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
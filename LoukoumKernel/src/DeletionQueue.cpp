@@ -0,0 +1,193 @@
+#include "DeletionQueue.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Deletion Queue constructor
+	/// </summary>
+	/// <param name="device"></param>
+	/// <param name="allocator">Allocator of buffers, images and allocations pushed</param>
+	/// <param name="timeline">Graphics queue timeline tagging resources, nullptr to count frames</param>
+	DeletionQueue::DeletionQueue(VkDevice device, MemoryAllocator* allocator, Timeline* timeline)
+	{
+		m_device = device;
+		m_allocator = allocator;
+		m_timeline = timeline;
+		m_frameNumber = 0;
+	}
+
+	/// <summary>
+	/// Deletion Queue destructor : GPU must be idle
+	/// </summary>
+	DeletionQueue::~DeletionQueue()
+	{
+		flush();
+	}
+
+	/// <summary>
+	/// Enqueue a destruction, run once the work submitted so far is done
+	/// </summary>
+	/// <param name="destroy">Destroys the resource</param>
+	void DeletionQueue::push(const std::function<void()>& destroy)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint64_t submitted = m_timeline != nullptr ? m_timeline->getLastSubmitted() : m_frameNumber;
+		m_destructions.push_back({ submitted, destroy });
+	}
+
+	/// <summary>
+	/// Enqueue a buffer and its memory, the allocation is reset
+	/// </summary>
+	/// <param name="buffer"></param>
+	/// <param name="allocation"></param>
+	void DeletionQueue::pushBuffer(VkBuffer buffer, Allocation& allocation)
+	{
+		MemoryAllocator* allocator = m_allocator;
+		Allocation memory = allocation;
+		allocation = Allocation();
+		push([allocator, buffer, memory]() mutable { allocator->destroyBuffer(buffer, memory); });
+	}
+
+	/// <summary>
+	/// Enqueue an image and its memory, the allocation is reset
+	/// </summary>
+	/// <param name="image"></param>
+	/// <param name="allocation"></param>
+	void DeletionQueue::pushImage(VkImage image, Allocation& allocation)
+	{
+		MemoryAllocator* allocator = m_allocator;
+		Allocation memory = allocation;
+		allocation = Allocation();
+		push([allocator, image, memory]() mutable { allocator->destroyImage(image, memory); });
+	}
+
+	/// <summary>
+	/// Enqueue memory of a resource destroyed already, the allocation is reset
+	/// </summary>
+	/// <param name="allocation"></param>
+	void DeletionQueue::pushAllocation(Allocation& allocation)
+	{
+		MemoryAllocator* allocator = m_allocator;
+		Allocation memory = allocation;
+		allocation = Allocation();
+		push([allocator, memory]() mutable { allocator->free(memory); });
+	}
+
+	/// <summary>
+	/// Enqueue an image view
+	/// </summary>
+	/// <param name="imageView"></param>
+	void DeletionQueue::pushImageView(VkImageView imageView)
+	{
+		VkDevice device = m_device;
+		push([device, imageView]() { vkDestroyImageView(device, imageView, nullptr); });
+	}
+
+	/// <summary>
+	/// Enqueue a framebuffer
+	/// </summary>
+	/// <param name="framebuffer"></param>
+	void DeletionQueue::pushFramebuffer(VkFramebuffer framebuffer)
+	{
+		VkDevice device = m_device;
+		push([device, framebuffer]() { vkDestroyFramebuffer(device, framebuffer, nullptr); });
+	}
+
+	/// <summary>
+	/// Enqueue a swapchain, its images go with it
+	/// </summary>
+	/// <param name="swapChain"></param>
+	void DeletionQueue::pushSwapchain(VkSwapchainKHR swapChain)
+	{
+		VkDevice device = m_device;
+		push([device, swapChain]() { vkDestroySwapchainKHR(device, swapChain, nullptr); });
+	}
+
+	/// <summary>
+	/// Enqueue a pipeline
+	/// </summary>
+	/// <param name="pipeline"></param>
+	void DeletionQueue::pushPipeline(VkPipeline pipeline)
+	{
+		VkDevice device = m_device;
+		push([device, pipeline]() { vkDestroyPipeline(device, pipeline, nullptr); });
+	}
+
+	/// <summary>
+	/// Enqueue a pipeline layout
+	/// </summary>
+	/// <param name="pipelineLayout"></param>
+	void DeletionQueue::pushPipelineLayout(VkPipelineLayout pipelineLayout)
+	{
+		VkDevice device = m_device;
+		push([device, pipelineLayout]() { vkDestroyPipelineLayout(device, pipelineLayout, nullptr); });
+	}
+
+	/// <summary>
+	/// Enqueue a render pass
+	/// </summary>
+	/// <param name="renderPass"></param>
+	void DeletionQueue::pushRenderPass(VkRenderPass renderPass)
+	{
+		VkDevice device = m_device;
+		push([device, renderPass]() { vkDestroyRenderPass(device, renderPass, nullptr); });
+	}
+
+	/// <summary>
+	/// Enqueue a shader module
+	/// </summary>
+	/// <param name="shaderModule"></param>
+	void DeletionQueue::pushShaderModule(VkShaderModule shaderModule)
+	{
+		VkDevice device = m_device;
+		push([device, shaderModule]() { vkDestroyShaderModule(device, shaderModule, nullptr); });
+	}
+
+	/// <summary>
+	/// Set the number of frames submitted, resources pushed from now on may be used by all of them
+	/// </summary>
+	/// <param name="frameNumber"></param>
+	void DeletionQueue::setFrameNumber(uint64_t frameNumber)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_frameNumber = frameNumber;
+	}
+
+	/// <summary>
+	/// Destroy resources no frame in flight can use
+	/// </summary>
+	/// <param name="completed">Frames [0, completed) are done on the GPU, or timeline value reached</param>
+	void DeletionQueue::collect(uint64_t completed)
+	{
+		//Destructions run without the lock : they may free memory or push again
+		std::deque<DeferredDestruction> ready;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			while (!m_destructions.empty() && m_destructions.front().submitted <= completed) {
+				ready.push_back(std::move(m_destructions.front()));
+				m_destructions.pop_front();
+			}
+		}
+
+		for (DeferredDestruction& destruction : ready)
+			destruction.destroy();
+	}
+
+	/// <summary>
+	/// Destroy all resources, GPU must be idle
+	/// </summary>
+	void DeletionQueue::flush()
+	{
+		collect(UINT64_MAX);
+	}
+
+	/// <summary>
+	/// Get number of resources waiting
+	/// </summary>
+	/// <returns></returns>
+	size_t DeletionQueue::getSize() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_destructions.size();
+	}
+}
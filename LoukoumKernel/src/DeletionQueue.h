@@ -0,0 +1,69 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+#include "MemoryAllocator.h"
+#include "Timeline.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Destruction waiting for the frames that may use a resource
+	/// </summary>
+	struct DeferredDestruction {
+		//Frames submitted, or last timeline value submitted, when the resource was released
+		uint64_t submitted = 0;
+		std::function<void()> destroy;
+	};
+
+	/// <summary>
+	/// Deletion Queue : resources released during a frame are destroyed once the GPU is done with them,
+	/// frames are counted by the frame fences, or any other increasing value like a timeline semaphore
+	/// </summary>
+	class DeletionQueue
+	{
+	public:
+		DeletionQueue(VkDevice device, MemoryAllocator* allocator, Timeline* timeline = nullptr);
+		~DeletionQueue();
+
+		//Enqueue, tagged with the current frame number or timeline value
+		void push(const std::function<void()>& destroy);
+		void pushBuffer(VkBuffer buffer, Allocation& allocation);
+		void pushImage(VkImage image, Allocation& allocation);
+		void pushAllocation(Allocation& allocation);
+		void pushImageView(VkImageView imageView);
+		void pushFramebuffer(VkFramebuffer framebuffer);
+		void pushSwapchain(VkSwapchainKHR swapChain);
+		void pushPipeline(VkPipeline pipeline);
+		void pushPipelineLayout(VkPipelineLayout pipelineLayout);
+		void pushRenderPass(VkRenderPass renderPass);
+		void pushShaderModule(VkShaderModule shaderModule);
+
+		//Without timeline : number of frames submitted
+		void setFrameNumber(uint64_t frameNumber);
+
+		//Frames done on the GPU, or timeline value reached
+		void collect(uint64_t completed);
+		void flush();
+
+		//Getters
+		size_t getSize() const;
+
+	private:
+		VkDevice m_device;
+		MemoryAllocator* m_allocator;
+		Timeline* m_timeline;
+
+		//Destructions in frame order
+		std::deque<DeferredDestruction> m_destructions;
+		uint64_t m_frameNumber;
+
+		mutable std::mutex m_mutex;
+	};
+}
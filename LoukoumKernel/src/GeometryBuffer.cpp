@@ -0,0 +1,195 @@
+#include "GeometryBuffer.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Constructor : create the device local buffer
+	/// </summary>
+	/// <param name="allocator">Memory allocator</param>
+	/// <param name="uploadManager">Upload manager used by flush</param>
+	/// <param name="deletionQueue">Deletion queue destroying buffers replaced by a growth</param>
+	/// <param name="usage">Buffer usage, TRANSFER_DST is added</param>
+	/// <param name="category">Memory category of the buffer</param>
+	/// <param name="initialCapacity">Capacity in bytes</param>
+	GeometryBuffer::GeometryBuffer(MemoryAllocator* allocator, UploadManager* uploadManager, DeletionQueue* deletionQueue, VkBufferUsageFlags usage, int category, VkDeviceSize initialCapacity)
+	{
+		m_allocator = allocator;
+		m_uploadManager = uploadManager;
+		m_deletionQueue = deletionQueue;
+		m_usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		m_category = category;
+		m_capacity = std::max(initialCapacity, MIN_CAPACITY);
+		m_buffer = m_allocator->createBuffer(m_capacity, m_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_allocation, m_category);
+	}
+
+	/// <summary>
+	/// Destructor : GPU must be idle
+	/// </summary>
+	GeometryBuffer::~GeometryBuffer()
+	{
+		m_allocator->destroyBuffer(m_buffer, m_allocation);
+	}
+
+	/// <summary>
+	/// Append data at the end of the buffer
+	/// </summary>
+	/// <param name="data"></param>
+	/// <param name="size"></param>
+	/// <returns>Offset of the data</returns>
+	VkDeviceSize GeometryBuffer::append(const void* data, VkDeviceSize size)
+	{
+		VkDeviceSize offset = m_data.size();
+		write(offset, data, size);
+		return offset;
+	}
+
+	/// <summary>
+	/// Write data, the buffer is enlarged if needed
+	/// </summary>
+	/// <param name="offset">Offset in bytes</param>
+	/// <param name="data"></param>
+	/// <param name="size"></param>
+	void GeometryBuffer::write(VkDeviceSize offset, const void* data, VkDeviceSize size)
+	{
+		if (size == 0)
+			return;
+
+		if (offset + size > m_data.size())
+			m_data.resize((size_t)(offset + size));
+
+		memcpy(m_data.data() + offset, data, (size_t)size);
+		markDirty(offset, size);
+	}
+
+	/// <summary>
+	/// Set used size, new bytes are zeroed, removed bytes are not uploaded
+	/// </summary>
+	/// <param name="size">Size in bytes</param>
+	void GeometryBuffer::resize(VkDeviceSize size)
+	{
+		VkDeviceSize oldSize = m_data.size();
+		m_data.resize((size_t)size, 0);
+
+		if (size > oldSize) {
+			markDirty(oldSize, size - oldSize);
+			return;
+		}
+
+		//Drop dirty ranges after the end
+		auto it = m_dirtyRanges.lower_bound(size);
+		m_dirtyRanges.erase(it, m_dirtyRanges.end());
+		if (!m_dirtyRanges.empty()) {
+			auto last = std::prev(m_dirtyRanges.end());
+			last->second = std::min(last->second, size);
+		}
+	}
+
+	/// <summary>
+	/// Upload dirty ranges through the upload manager, grow first if needed
+	/// </summary>
+	/// <returns>True when the buffer was replaced : command buffers must be recorded again</returns>
+	bool GeometryBuffer::flush()
+	{
+		bool reallocated = false;
+		if (m_data.size() > m_capacity) {
+			grow(m_data.size());
+			reallocated = true;
+		}
+
+		//A new buffer is filled like any upload, the buffer in use stays on the graphics queue
+		for (auto& range : m_dirtyRanges) {
+			if (reallocated)
+				m_uploadManager->upload(m_buffer, range.first, m_data.data() + range.first, range.second - range.first);
+			else
+				m_uploadManager->update(m_buffer, range.first, m_data.data() + range.first, range.second - range.first);
+		}
+		m_dirtyRanges.clear();
+
+		return reallocated;
+	}
+
+	/// <summary>
+	/// Get Vulkan buffer
+	/// </summary>
+	/// <returns></returns>
+	VkBuffer GeometryBuffer::getBuffer() const
+	{
+		return m_buffer;
+	}
+
+	/// <summary>
+	/// Get used size
+	/// </summary>
+	/// <returns>Size in bytes</returns>
+	VkDeviceSize GeometryBuffer::getSize() const
+	{
+		return m_data.size();
+	}
+
+	/// <summary>
+	/// Get capacity of the GPU buffer
+	/// </summary>
+	/// <returns>Capacity in bytes</returns>
+	VkDeviceSize GeometryBuffer::getCapacity() const
+	{
+		return m_capacity;
+	}
+
+	/// <summary>
+	/// Get CPU copy
+	/// </summary>
+	/// <returns></returns>
+	const uint8_t* GeometryBuffer::getData() const
+	{
+		return m_data.data();
+	}
+
+	/// <summary>
+	/// Add a range to upload, merged with the ranges it touches or almost touches
+	/// </summary>
+	/// <param name="offset"></param>
+	/// <param name="size"></param>
+	void GeometryBuffer::markDirty(VkDeviceSize offset, VkDeviceSize size)
+	{
+		VkDeviceSize begin = offset;
+		VkDeviceSize end = offset + size;
+
+		//Previous range reaching the new one
+		auto it = m_dirtyRanges.upper_bound(begin);
+		if (it != m_dirtyRanges.begin()) {
+			auto previous = std::prev(it);
+			if (previous->second + MERGE_GAP >= begin) {
+				begin = previous->first;
+				end = std::max(end, previous->second);
+				it = m_dirtyRanges.erase(previous);
+			}
+		}
+
+		//Next ranges starting in the new one
+		while (it != m_dirtyRanges.end() && it->first <= end + MERGE_GAP) {
+			end = std::max(end, it->second);
+			it = m_dirtyRanges.erase(it);
+		}
+
+		m_dirtyRanges[begin] = std::min(end, (VkDeviceSize)m_data.size());
+	}
+
+	/// <summary>
+	/// Replace the buffer with a larger one, the whole content is uploaded again
+	/// The old buffer is destroyed once the frames using it are done
+	/// </summary>
+	/// <param name="size">Minimum capacity</param>
+	void GeometryBuffer::grow(VkDeviceSize size)
+	{
+		VkDeviceSize capacity = m_capacity;
+		while (capacity < size)
+			capacity *= 2;
+
+		m_deletionQueue->pushBuffer(m_buffer, m_allocation);
+		m_buffer = m_allocator->createBuffer(capacity, m_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_allocation, m_category);
+		m_capacity = capacity;
+
+		m_dirtyRanges.clear();
+		m_dirtyRanges[0] = m_data.size();
+	}
+}
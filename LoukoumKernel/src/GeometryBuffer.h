@@ -0,0 +1,65 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cstring>
+
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "DeletionQueue.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Device local buffer with a CPU copy : grows geometrically, only dirty ranges are uploaded
+	/// </summary>
+	class GeometryBuffer
+	{
+	public:
+		GeometryBuffer(MemoryAllocator* allocator, UploadManager* uploadManager, DeletionQueue* deletionQueue, VkBufferUsageFlags usage, int category, VkDeviceSize initialCapacity = MIN_CAPACITY);
+		~GeometryBuffer();
+
+		//CPU side edits, uploaded on next flush
+		VkDeviceSize append(const void* data, VkDeviceSize size);
+		void write(VkDeviceSize offset, const void* data, VkDeviceSize size);
+		void resize(VkDeviceSize size);
+
+		//Upload dirty ranges, returns true when the VkBuffer changed
+		bool flush();
+
+		//Getters
+		VkBuffer getBuffer() const;
+		VkDeviceSize getSize() const;
+		VkDeviceSize getCapacity() const;
+		const uint8_t* getData() const;
+
+		//Smallest buffer created
+		static constexpr VkDeviceSize MIN_CAPACITY = 64 * 1024;
+
+		//Dirty ranges closer than this are uploaded with one copy
+		static constexpr VkDeviceSize MERGE_GAP = 256;
+
+	private:
+		void markDirty(VkDeviceSize offset, VkDeviceSize size);
+		void grow(VkDeviceSize size);
+
+		MemoryAllocator* m_allocator;
+		UploadManager* m_uploadManager;
+		DeletionQueue* m_deletionQueue;
+		VkBufferUsageFlags m_usage;
+		int m_category;
+
+		//GPU buffer
+		VkBuffer m_buffer;
+		Allocation m_allocation;
+		VkDeviceSize m_capacity;
+
+		//CPU copy and ranges changed since last flush (begin -> end)
+		std::vector<uint8_t> m_data;
+		std::map<VkDeviceSize, VkDeviceSize> m_dirtyRanges;
+	};
+}
@@ -27,11 +27,14 @@ namespace Loukoum
 		initWindow();
 		initVulkan();
 
-		m_vulkan->addVertex(glm::vec3(-0.7, -0.5, 0), glm::vec4(1, 0, 0.2, 0.2));
-		m_vulkan->addVertex(glm::vec3(0.5, -0.7, 0), glm::vec4(0.7, 1, 0, 1));
-		m_vulkan->addVertex(glm::vec3(0, 0.8, 0), glm::vec4(0, 0.5, 1, 1));
+		std::vector<Vertex> vertices = {
+			{ glm::vec3(-0.7, -0.5, 0), glm::vec4(1, 0, 0.2, 0.2) },
+			{ glm::vec3(0.5, -0.7, 0), glm::vec4(0.7, 1, 0, 1) },
+			{ glm::vec3(0, 0.8, 0), glm::vec4(0, 0.5, 1, 1) }
+		};
+		m_vulkan->addVertices(std::move(vertices), { 0, 1, 2 });
 		m_vulkan->createVertexBuffer();
-		m_vulkan->recreateSwapChain();
+		m_vulkan->printMemoryStats();
 
 		mainLoop();
 		cleanUp();
@@ -89,6 +92,8 @@ namespace Loukoum
 			glfwPollEvents();
 			m_vulkan->drawFrame();
 		}
+		m_vulkan->printResizeStats();
+		m_vulkan->printFramePacingStats();
 
 		std::cout << "Loukoum : main loop ended" << std::endl;
 	}
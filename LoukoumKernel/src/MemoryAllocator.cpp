@@ -0,0 +1,658 @@
+#include "MemoryAllocator.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Align offset on the next multiple of alignment
+	/// </summary>
+	/// <param name="offset"></param>
+	/// <param name="alignment"></param>
+	/// <returns></returns>
+	static VkDeviceSize alignUp(VkDeviceSize offset, VkDeviceSize alignment)
+	{
+		if (alignment <= 1)
+			return offset;
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	/// <summary>
+	/// Memory Block constructor : whole memory is free
+	/// </summary>
+	/// <param name="memory">Device memory of the block</param>
+	/// <param name="size">Block size</param>
+	/// <param name="memoryTypeIndex">Memory type of the block</param>
+	/// <param name="linear">Block holds buffers and linear images, else optimal images</param>
+	/// <param name="dedicated">Block holds a single resource</param>
+	/// <param name="mappedData">Persistent mapping, nullptr if not host visible</param>
+	MemoryBlock::MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, bool linear, bool dedicated, void* mappedData)
+	{
+		m_memory = memory;
+		m_size = size;
+		m_memoryTypeIndex = memoryTypeIndex;
+		m_linear = linear;
+		m_dedicated = dedicated;
+		m_mappedData = mappedData;
+		m_allocationCount = 0;
+
+		insertFreeRange(0, size);
+	}
+
+	/// <summary>
+	/// Find the smallest free range able to hold size bytes aligned on alignment
+	/// </summary>
+	/// <param name="size"></param>
+	/// <param name="alignment"></param>
+	/// <param name="offset">Offset of the sub-allocation in the block</param>
+	/// <returns>false if no free range is large enough</returns>
+	bool MemoryBlock::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+	{
+		//Best fit : ranges are sorted by size, first one that fits after alignment is taken
+		for (auto it = m_freeBySize.lower_bound(size); it != m_freeBySize.end(); it++)
+		{
+			VkDeviceSize rangeOffset = it->second;
+			VkDeviceSize rangeSize = it->first;
+			VkDeviceSize alignedOffset = alignUp(rangeOffset, alignment);
+			VkDeviceSize padding = alignedOffset - rangeOffset;
+
+			if (padding + size > rangeSize)
+				continue;
+
+			//Split the range : padding before, remaining bytes after
+			eraseFreeRange(m_freeByOffset.find(rangeOffset));
+			if (padding > 0)
+				insertFreeRange(rangeOffset, padding);
+			if (padding + size < rangeSize)
+				insertFreeRange(alignedOffset + size, rangeSize - padding - size);
+
+			offset = alignedOffset;
+			m_allocationCount++;
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Give back a sub-allocation and merge it with free neighbours
+	/// </summary>
+	/// <param name="offset"></param>
+	/// <param name="size"></param>
+	void MemoryBlock::free(VkDeviceSize offset, VkDeviceSize size)
+	{
+		//Merge with next free range
+		auto next = m_freeByOffset.lower_bound(offset);
+		if (next != m_freeByOffset.end() && next->first == offset + size) {
+			size += next->second;
+			eraseFreeRange(next);
+		}
+
+		//Merge with previous free range
+		next = m_freeByOffset.lower_bound(offset);
+		if (next != m_freeByOffset.begin()) {
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset) {
+				offset = prev->first;
+				size += prev->second;
+				eraseFreeRange(prev);
+			}
+		}
+
+		insertFreeRange(offset, size);
+		m_allocationCount--;
+	}
+
+	/// <summary>
+	/// Get Device Memory
+	/// </summary>
+	/// <returns></returns>
+	VkDeviceMemory MemoryBlock::getMemory() const
+	{
+		return m_memory;
+	}
+
+	/// <summary>
+	/// Get Block Size
+	/// </summary>
+	/// <returns></returns>
+	VkDeviceSize MemoryBlock::getSize() const
+	{
+		return m_size;
+	}
+
+	/// <summary>
+	/// Get Memory Type Index
+	/// </summary>
+	/// <returns></returns>
+	uint32_t MemoryBlock::getMemoryTypeIndex() const
+	{
+		return m_memoryTypeIndex;
+	}
+
+	/// <summary>
+	/// Is block holding linear resources
+	/// </summary>
+	/// <returns></returns>
+	bool MemoryBlock::isLinear() const
+	{
+		return m_linear;
+	}
+
+	/// <summary>
+	/// Is block dedicated to a single resource
+	/// </summary>
+	/// <returns></returns>
+	bool MemoryBlock::isDedicated() const
+	{
+		return m_dedicated;
+	}
+
+	/// <summary>
+	/// Is block without any sub-allocation
+	/// </summary>
+	/// <returns></returns>
+	bool MemoryBlock::isEmpty() const
+	{
+		return m_allocationCount == 0;
+	}
+
+	/// <summary>
+	/// Get persistent mapping of the block
+	/// </summary>
+	/// <returns></returns>
+	void* MemoryBlock::getMappedData() const
+	{
+		return m_mappedData;
+	}
+
+	/// <summary>
+	/// Add block usage to statistics
+	/// </summary>
+	/// <param name="stats"></param>
+	void MemoryBlock::addStats(MemoryStats& stats) const
+	{
+		VkDeviceSize freeBytes = 0;
+		for (const auto& range : m_freeByOffset)
+			freeBytes += range.second;
+
+		stats.blockCount++;
+		stats.allocationCount += m_allocationCount;
+		stats.freeRangeCount += static_cast<uint32_t>(m_freeByOffset.size());
+		stats.blockBytes += m_size;
+		stats.usedBytes += m_size - freeBytes;
+		stats.freeBytes += freeBytes;
+		if (!m_freeBySize.empty())
+			stats.largestFreeRange = std::max(stats.largestFreeRange, m_freeBySize.rbegin()->first);
+	}
+
+	/// <summary>
+	/// Insert a free range in both lookups
+	/// </summary>
+	/// <param name="offset"></param>
+	/// <param name="size"></param>
+	void MemoryBlock::insertFreeRange(VkDeviceSize offset, VkDeviceSize size)
+	{
+		m_freeByOffset[offset] = size;
+		m_freeBySize.insert({ size, offset });
+	}
+
+	/// <summary>
+	/// Erase a free range from both lookups
+	/// </summary>
+	/// <param name="it">Iterator in the offset lookup</param>
+	void MemoryBlock::eraseFreeRange(std::map<VkDeviceSize, VkDeviceSize>::iterator it)
+	{
+		auto range = m_freeBySize.equal_range(it->second);
+		for (auto sizeIt = range.first; sizeIt != range.second; sizeIt++) {
+			if (sizeIt->second == it->first) {
+				m_freeBySize.erase(sizeIt);
+				break;
+			}
+		}
+		m_freeByOffset.erase(it);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+
+	/// <summary>
+	/// Memory Allocator constructor
+	/// </summary>
+	/// <param name="physicalDevice"></param>
+	/// <param name="device"></param>
+	/// <param name="budgetExtension">true when VK_EXT_memory_budget is enabled on the device</param>
+	MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, bool budgetExtension)
+		: m_budget(physicalDevice, budgetExtension)
+	{
+		m_physicalDevice = physicalDevice;
+		m_device = device;
+		vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+		m_bufferImageGranularity = properties.limits.bufferImageGranularity;
+	}
+
+	/// <summary>
+	/// Memory Allocator destructor : free all blocks
+	/// </summary>
+	MemoryAllocator::~MemoryAllocator()
+	{
+		for (MemoryBlock* block : m_blocks)
+		{
+			if (!block->isEmpty())
+				std::cout << "Loukoum : memory block destroyed with living allocations" << std::endl;
+			destroyBlock(block);
+		}
+		m_blocks.clear();
+	}
+
+	/// <summary>
+	/// Sub-allocate memory from a block of a suitable memory type
+	/// </summary>
+	/// <param name="requirements">Memory requirements of the resource</param>
+	/// <param name="properties">Wanted memory properties</param>
+	/// <param name="linear">true for buffers and linear images, false for optimal images</param>
+	/// <param name="category">MEMORY_CATEGORY_* tracked by the budget</param>
+	/// <returns></returns>
+	Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, int category)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		//Linear and optimal resources only share blocks when the granularity can't make them alias
+		if (m_bufferImageGranularity <= 1)
+			linear = true;
+
+		//Try each memory type matching requirements, the first one is the best for the driver
+		for (uint32_t type = 0; type < m_memoryProperties.memoryTypeCount; type++)
+		{
+			if (!(requirements.memoryTypeBits & (1 << type)) || (m_memoryProperties.memoryTypes[type].propertyFlags & properties) != properties)
+				continue;
+
+			VkDeviceSize blockSize = getBlockSize(type);
+			MemoryBlock* target = nullptr;
+			VkDeviceSize offset = 0;
+
+			//Large resources get their own block
+			if (requirements.size > blockSize / 2)
+			{
+				target = createBlock(requirements.size, type, linear, true);
+				if (target != nullptr)
+					target->allocate(requirements.size, requirements.alignment, offset);
+			}
+			else
+			{
+				//Existing blocks
+				for (MemoryBlock* block : m_blocks)
+				{
+					if (block->isDedicated() || block->getMemoryTypeIndex() != type || block->isLinear() != linear)
+						continue;
+					if (block->allocate(requirements.size, requirements.alignment, offset)) {
+						target = block;
+						break;
+					}
+				}
+
+				//New block
+				if (target == nullptr)
+				{
+					target = createBlock(blockSize, type, linear, false);
+					if (target != nullptr)
+						target->allocate(requirements.size, requirements.alignment, offset);
+				}
+			}
+
+			//Memory type heap is full, try the next one
+			if (target == nullptr)
+				continue;
+
+			Allocation allocation;
+			allocation.memory = target->getMemory();
+			allocation.offset = offset;
+			allocation.size = requirements.size;
+			allocation.block = target;
+			allocation.category = category;
+			if (target->getMappedData() != nullptr)
+				allocation.mappedData = static_cast<char*>(target->getMappedData()) + offset;
+			m_budget.addAllocation(category, allocation.size);
+			return allocation;
+		}
+
+		throw std::runtime_error("Failed to allocate device memory");
+	}
+
+	/// <summary>
+	/// Free a sub-allocation, empty blocks are released
+	/// </summary>
+	/// <param name="allocation"></param>
+	void MemoryAllocator::free(Allocation& allocation)
+	{
+		if (!allocation.isValid())
+			return;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		MemoryBlock* block = allocation.block;
+		block->free(allocation.offset, allocation.size);
+		m_budget.removeAllocation(allocation.category, allocation.size);
+		allocation = Allocation();
+
+		if (!block->isEmpty())
+			return;
+
+		//Keep one empty block per memory type to avoid allocation ping-pong
+		bool release = block->isDedicated();
+		for (MemoryBlock* other : m_blocks)
+		{
+			if (other != block && !other->isDedicated() && other->isEmpty() &&
+				other->getMemoryTypeIndex() == block->getMemoryTypeIndex() && other->isLinear() == block->isLinear())
+				release = true;
+		}
+
+		if (release)
+		{
+			m_blocks.erase(std::find(m_blocks.begin(), m_blocks.end(), block));
+			destroyBlock(block);
+		}
+	}
+
+	/// <summary>
+	/// Create a buffer bound to a sub-allocation
+	/// </summary>
+	/// <param name="size"></param>
+	/// <param name="usage"></param>
+	/// <param name="properties"></param>
+	/// <param name="allocation">Filled with the buffer memory</param>
+	/// <param name="category">MEMORY_CATEGORY_*</param>
+	/// <param name="priority">MEMORY_PRIORITY_*</param>
+	/// <param name="queueFamilies">Families using the buffer concurrently, empty for exclusive ownership</param>
+	/// <returns></returns>
+	VkBuffer MemoryAllocator::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, Allocation& allocation, int category, int priority, const std::vector<uint32_t>& queueFamilies)
+	{
+		//Buffer info
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (queueFamilies.size() > 1) {
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+			bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+		}
+
+		//Create Buffer
+		VkBuffer buffer;
+		if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create buffer");
+		}
+
+		//Memory requirements
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+		//Over budget : evict lower priority resources, low priority buffers are refused until evictions are released
+		if (!makeRoom(memRequirements, properties, priority) && priority == MEMORY_PRIORITY_LOW) {
+			vkDestroyBuffer(m_device, buffer, nullptr);
+			throw std::runtime_error("Failed to create buffer : over memory budget");
+		}
+
+		//Sub-allocate and bind
+		try {
+			allocation = allocate(memRequirements, properties, true, category);
+		}
+		catch (...) {
+			vkDestroyBuffer(m_device, buffer, nullptr);
+			throw;
+		}
+		vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+
+		return buffer;
+	}
+
+	/// <summary>
+	/// Destroy a buffer and free its memory
+	/// </summary>
+	/// <param name="buffer"></param>
+	/// <param name="allocation"></param>
+	void MemoryAllocator::destroyBuffer(VkBuffer buffer, Allocation& allocation)
+	{
+		vkDestroyBuffer(m_device, buffer, nullptr);
+		free(allocation);
+	}
+
+	/// <summary>
+	/// Create an image bound to a sub-allocation
+	/// </summary>
+	/// <param name="imageInfo"></param>
+	/// <param name="properties"></param>
+	/// <param name="allocation">Filled with the image memory</param>
+	/// <param name="category">MEMORY_CATEGORY_*</param>
+	/// <param name="priority">MEMORY_PRIORITY_*</param>
+	/// <returns></returns>
+	VkImage MemoryAllocator::createImage(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, Allocation& allocation, int category, int priority)
+	{
+		//Create Image
+		VkImage image;
+		if (vkCreateImage(m_device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create image");
+		}
+
+		//Memory requirements
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(m_device, image, &memRequirements);
+
+		//Over budget : evict lower priority resources, low priority images are refused until evictions are released
+		if (!makeRoom(memRequirements, properties, priority) && priority == MEMORY_PRIORITY_LOW) {
+			vkDestroyImage(m_device, image, nullptr);
+			throw std::runtime_error("Failed to create image : over memory budget");
+		}
+
+		//Sub-allocate and bind
+		try {
+			allocation = allocate(memRequirements, properties, imageInfo.tiling == VK_IMAGE_TILING_LINEAR, category);
+		}
+		catch (...) {
+			vkDestroyImage(m_device, image, nullptr);
+			throw;
+		}
+		vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+
+		return image;
+	}
+
+	/// <summary>
+	/// Destroy an image and free its memory
+	/// </summary>
+	/// <param name="image"></param>
+	/// <param name="allocation"></param>
+	void MemoryAllocator::destroyImage(VkImage image, Allocation& allocation)
+	{
+		vkDestroyImage(m_device, image, nullptr);
+		free(allocation);
+	}
+
+	/// <summary>
+	/// Find suitable memory type for memory allocation
+	/// </summary>
+	/// <param name="typeFilter"></param>
+	/// <param name="properties"></param>
+	/// <returns></returns>
+	uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+
+		throw std::runtime_error("Failed to find suitable memory type!");
+	}
+
+	/// <summary>
+	/// Get heap of an allocation, throws for a freed or empty allocation
+	/// </summary>
+	/// <param name="allocation"></param>
+	/// <returns></returns>
+	uint32_t MemoryAllocator::getHeapIndex(const Allocation& allocation) const
+	{
+		if (!allocation.isValid())
+			throw std::runtime_error("Failed to get heap index : invalid allocation");
+
+		return m_memoryProperties.memoryTypes[allocation.block->getMemoryTypeIndex()].heapIndex;
+	}
+
+	/// <summary>
+	/// Query heap budgets from the driver, once per frame
+	/// </summary>
+	void MemoryAllocator::updateBudget()
+	{
+		m_budget.update();
+	}
+
+	/// <summary>
+	/// Get memory budget and usage per category
+	/// </summary>
+	/// <returns></returns>
+	const MemoryBudget& MemoryAllocator::getBudget() const
+	{
+		return m_budget;
+	}
+
+	/// <summary>
+	/// Set the callback freeing low priority resources when a heap is over budget
+	/// Called without the allocator lock : it can destroy buffers and images
+	/// </summary>
+	/// <param name="callback"></param>
+	void MemoryAllocator::setEvictionCallback(const MemoryEvictionCallback& callback)
+	{
+		m_evictionCallback = callback;
+	}
+
+	/// <summary>
+	/// Get memory usage statistics of all blocks
+	/// </summary>
+	/// <returns></returns>
+	MemoryStats MemoryAllocator::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		MemoryStats stats;
+		for (MemoryBlock* block : m_blocks)
+			block->addStats(stats);
+
+		if (stats.freeBytes > 0)
+			stats.fragmentation = 1.0f - (float)stats.largestFreeRange / (float)stats.freeBytes;
+
+		return stats;
+	}
+
+	/// <summary>
+	/// Print memory statistics in the console
+	/// </summary>
+	void MemoryAllocator::printStats() const
+	{
+		MemoryStats stats = getStats();
+
+		std::cout << std::endl;
+		std::cout << "GPU Memory" << std::endl;
+		std::cout << "--Blocks : " << stats.blockCount << " | " << stats.blockBytes / 1024 << " KiB" << std::endl;
+		std::cout << "--Allocations : " << stats.allocationCount << " | " << stats.usedBytes / 1024 << " KiB used" << std::endl;
+		std::cout << "--Free : " << stats.freeBytes / 1024 << " KiB in " << stats.freeRangeCount << " ranges | largest " << stats.largestFreeRange / 1024 << " KiB" << std::endl;
+		std::cout << "--Fragmentation : " << stats.fragmentation * 100.0f << " %" << std::endl;
+		std::cout << std::endl;
+		m_budget.printBudget();
+	}
+
+	/// <summary>
+	/// Allocate a new device memory block, persistently mapped if host visible
+	/// </summary>
+	/// <param name="size"></param>
+	/// <param name="memoryTypeIndex"></param>
+	/// <param name="linear"></param>
+	/// <param name="dedicated"></param>
+	/// <returns>nullptr if the heap is full</returns>
+	MemoryBlock* MemoryAllocator::createBlock(VkDeviceSize size, uint32_t memoryTypeIndex, bool linear, bool dedicated)
+	{
+		//Memory allocation info
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		//Allocation
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(m_device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+			return nullptr;
+
+		//Map the whole block once
+		void* mappedData = nullptr;
+		if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			if (vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData) != VK_SUCCESS) {
+				vkFreeMemory(m_device, memory, nullptr);
+				throw std::runtime_error("Failed to map memory block");
+			}
+		}
+
+		MemoryBlock* block = new MemoryBlock(memory, size, memoryTypeIndex, linear, dedicated, mappedData);
+		m_blocks.push_back(block);
+		m_budget.addBlock(m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex, size);
+		return block;
+	}
+
+	/// <summary>
+	/// Free the device memory of a block
+	/// </summary>
+	/// <param name="block"></param>
+	void MemoryAllocator::destroyBlock(MemoryBlock* block)
+	{
+		if (block->getMappedData() != nullptr)
+			vkUnmapMemory(m_device, block->getMemory());
+		vkFreeMemory(m_device, block->getMemory(), nullptr);
+		m_budget.removeBlock(m_memoryProperties.memoryTypes[block->getMemoryTypeIndex()].heapIndex, block->getSize());
+		delete block;
+	}
+
+	/// <summary>
+	/// Get block size of a memory type, smaller for small heaps
+	/// </summary>
+	/// <param name="memoryTypeIndex"></param>
+	/// <returns></returns>
+	VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) const
+	{
+		uint32_t heapIndex = m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+		VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[heapIndex].size;
+		return std::min(DEFAULT_BLOCK_SIZE, heapSize / 8);
+	}
+
+	/// <summary>
+	/// Keep a heap in budget before an allocation : schedule lower priority resources for eviction until the size fits
+	/// Evicted memory is freed once the frames using it are done, the heap is still over budget on return
+	/// The size is counted as a new block, it may land in an existing one
+	/// </summary>
+	/// <param name="requirements">Memory requirements of the resource</param>
+	/// <param name="properties">Wanted memory properties</param>
+	/// <param name="priority">MEMORY_PRIORITY_* of the resource</param>
+	/// <returns>false if the heap is over budget now, the allocation can be retried once evictions are released</returns>
+	bool MemoryAllocator::makeRoom(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, int priority)
+	{
+		//Heap of the memory type allocate tries first
+		uint32_t heapIndex = m_memoryProperties.memoryTypes[findMemoryType(requirements.memoryTypeBits, properties)].heapIndex;
+
+		VkDeviceSize released = 0;
+		while (!m_budget.fits(heapIndex, requirements.size, priority, released))
+		{
+			VkDeviceSize evicted = m_evictionCallback ? m_evictionCallback(heapIndex, requirements.size, priority) : 0;
+			if (evicted == 0) {
+				std::cout << "Loukoum : memory heap " << heapIndex << " over budget" << std::endl;
+				return false;
+			}
+			released += evicted;
+		}
+
+		if (released > 0) {
+			std::cout << "Loukoum : memory heap " << heapIndex << " over budget until " << released << " evicted bytes are released" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+}
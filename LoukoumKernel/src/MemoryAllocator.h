@@ -0,0 +1,149 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <functional>
+
+#include "MemoryBudget.h"
+
+namespace Loukoum
+{
+	class MemoryBlock;
+
+	/// <summary>
+	/// Sub-allocation handle given by the Memory Allocator
+	/// </summary>
+	struct Allocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mappedData = nullptr;
+		MemoryBlock* block = nullptr;
+		int category = MEMORY_CATEGORY_VERTEX;
+
+		bool isValid() const {
+			return block != nullptr;
+		}
+	};
+
+	/// <summary>
+	/// Memory usage and fragmentation statistics
+	/// </summary>
+	struct MemoryStats {
+		uint32_t blockCount = 0;
+		uint32_t allocationCount = 0;
+		uint32_t freeRangeCount = 0;
+		VkDeviceSize blockBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize freeBytes = 0;
+		VkDeviceSize largestFreeRange = 0;
+
+		//0 when all free memory is contiguous, near 1 when free memory is split in small ranges
+		float fragmentation = 0.0f;
+	};
+
+	//Schedules resources of lower priority than the request in a heap for release, returns the bytes scheduled, 0 when nothing can be evicted
+	//Called during an allocation : must not allocate, free or wait, memory is released later by the deletion queue
+	using MemoryEvictionCallback = std::function<VkDeviceSize(uint32_t heapIndex, VkDeviceSize size, int priority)>;
+
+	/// <summary>
+	/// Large VkDeviceMemory block carved in sub-allocations
+	/// </summary>
+	class MemoryBlock
+	{
+	public:
+		MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, bool linear, bool dedicated, void* mappedData);
+
+		//Sub-allocation
+		bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+		void free(VkDeviceSize offset, VkDeviceSize size);
+
+		//Getters
+		VkDeviceMemory getMemory() const;
+		VkDeviceSize getSize() const;
+		uint32_t getMemoryTypeIndex() const;
+		bool isLinear() const;
+		bool isDedicated() const;
+		bool isEmpty() const;
+		void* getMappedData() const;
+		void addStats(MemoryStats& stats) const;
+
+	private:
+		void insertFreeRange(VkDeviceSize offset, VkDeviceSize size);
+		void eraseFreeRange(std::map<VkDeviceSize, VkDeviceSize>::iterator it);
+
+		VkDeviceMemory m_memory;
+		VkDeviceSize m_size;
+		uint32_t m_memoryTypeIndex;
+		bool m_linear;
+		bool m_dedicated;
+		void* m_mappedData;
+		uint32_t m_allocationCount;
+
+		//Free ranges sorted by offset (to merge neighbours) and by size (to find the best fit)
+		std::map<VkDeviceSize, VkDeviceSize> m_freeByOffset;
+		std::multimap<VkDeviceSize, VkDeviceSize> m_freeBySize;
+	};
+
+	/// <summary>
+	/// Device memory allocator : few large blocks per memory type instead of one vkAllocateMemory per resource
+	/// </summary>
+	class MemoryAllocator
+	{
+	public:
+		MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, bool budgetExtension = false);
+		~MemoryAllocator();
+
+		//Raw memory
+		Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, int category);
+		void free(Allocation& allocation);
+
+		//Buffers, low priority buffers are refused over budget, shared by the queue families given
+		VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, Allocation& allocation, int category, int priority = MEMORY_PRIORITY_NORMAL, const std::vector<uint32_t>& queueFamilies = {});
+		void destroyBuffer(VkBuffer buffer, Allocation& allocation);
+
+		//Images, low priority images are refused over budget
+		VkImage createImage(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, Allocation& allocation, int category, int priority = MEMORY_PRIORITY_NORMAL);
+		void destroyImage(VkImage image, Allocation& allocation);
+
+		//Memory types
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		uint32_t getHeapIndex(const Allocation& allocation) const;
+
+		//Budget
+		void updateBudget();
+		const MemoryBudget& getBudget() const;
+		void setEvictionCallback(const MemoryEvictionCallback& callback);
+
+		//Statistics
+		MemoryStats getStats() const;
+		void printStats() const;
+
+		//Default size of a memory block
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+	private:
+		MemoryBlock* createBlock(VkDeviceSize size, uint32_t memoryTypeIndex, bool linear, bool dedicated);
+		void destroyBlock(MemoryBlock* block);
+		VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+		bool makeRoom(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, int priority);
+
+		VkPhysicalDevice m_physicalDevice;
+		VkDevice m_device;
+		VkPhysicalDeviceMemoryProperties m_memoryProperties;
+		VkDeviceSize m_bufferImageGranularity;
+
+		std::vector<MemoryBlock*> m_blocks;
+		mutable std::mutex m_mutex;
+
+		//Budget and eviction of low priority resources
+		MemoryBudget m_budget;
+		MemoryEvictionCallback m_evictionCallback;
+	};
+}
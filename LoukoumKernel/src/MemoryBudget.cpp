@@ -0,0 +1,202 @@
+#include "MemoryBudget.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Memory Budget constructor
+	/// </summary>
+	/// <param name="physicalDevice"></param>
+	/// <param name="budgetExtension">true when VK_EXT_memory_budget is enabled on the device</param>
+	MemoryBudget::MemoryBudget(VkPhysicalDevice physicalDevice, bool budgetExtension)
+	{
+		m_physicalDevice = physicalDevice;
+		m_budgetExtension = budgetExtension;
+		vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
+
+		m_heaps.resize(m_memoryProperties.memoryHeapCount);
+		m_blockBytesAtUpdate.resize(m_memoryProperties.memoryHeapCount, 0);
+		for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++) {
+			m_heaps[i].size = m_memoryProperties.memoryHeaps[i].size;
+			m_heaps[i].deviceLocal = (m_memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		}
+
+		update();
+	}
+
+	/// <summary>
+	/// Query heap budgets and usage
+	/// Without VK_EXT_memory_budget, the budget is a share of the heap and the usage is the allocator blocks
+	/// </summary>
+	void MemoryBudget::update()
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		if (m_budgetExtension) {
+			VkPhysicalDeviceMemoryProperties2 properties{};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties.pNext = &budgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &properties);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (uint32_t i = 0; i < m_heaps.size(); i++) {
+			MemoryHeapBudget& heap = m_heaps[i];
+			if (m_budgetExtension) {
+				heap.budget = budgetProperties.heapBudget[i];
+				heap.usage = budgetProperties.heapUsage[i];
+			}
+			else {
+				heap.budget = (VkDeviceSize)(heap.size * HEURISTIC_BUDGET);
+				heap.usage = heap.blockBytes;
+			}
+			m_blockBytesAtUpdate[i] = heap.blockBytes;
+		}
+	}
+
+	/// <summary>
+	/// Track a new memory block
+	/// </summary>
+	/// <param name="heapIndex"></param>
+	/// <param name="size"></param>
+	void MemoryBudget::addBlock(uint32_t heapIndex, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_heaps[heapIndex].blockBytes += size;
+	}
+
+	/// <summary>
+	/// Track a freed memory block
+	/// </summary>
+	/// <param name="heapIndex"></param>
+	/// <param name="size"></param>
+	void MemoryBudget::removeBlock(uint32_t heapIndex, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_heaps[heapIndex].blockBytes -= size;
+	}
+
+	/// <summary>
+	/// Track a new sub-allocation
+	/// </summary>
+	/// <param name="category">MEMORY_CATEGORY_*</param>
+	/// <param name="size"></param>
+	void MemoryBudget::addAllocation(int category, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_categories[category].allocationCount++;
+		m_categories[category].bytes += size;
+	}
+
+	/// <summary>
+	/// Track a freed sub-allocation
+	/// </summary>
+	/// <param name="category">MEMORY_CATEGORY_*</param>
+	/// <param name="size"></param>
+	void MemoryBudget::removeAllocation(int category, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_categories[category].allocationCount--;
+		m_categories[category].bytes -= size;
+	}
+
+	/// <summary>
+	/// Check if size more bytes stay in the share of the heap budget allowed to a priority
+	/// </summary>
+	/// <param name="heapIndex"></param>
+	/// <param name="size"></param>
+	/// <param name="priority">MEMORY_PRIORITY_*</param>
+	/// <param name="released">Bytes scheduled for release, not counted in the usage</param>
+	/// <returns></returns>
+	bool MemoryBudget::fits(uint32_t heapIndex, VkDeviceSize size, int priority, VkDeviceSize released) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		float limit = 1.0f;
+		if (priority == MEMORY_PRIORITY_LOW)
+			limit = LOW_PRIORITY_LIMIT;
+		else if (priority == MEMORY_PRIORITY_NORMAL)
+			limit = NORMAL_PRIORITY_LIMIT;
+
+		VkDeviceSize usage = getUsage(heapIndex);
+		usage -= std::min(usage, released);
+		return usage + size <= (VkDeviceSize)(m_heaps[heapIndex].budget * limit);
+	}
+
+	/// <summary>
+	/// Get number of memory heaps
+	/// </summary>
+	/// <returns></returns>
+	uint32_t MemoryBudget::getHeapCount() const
+	{
+		return static_cast<uint32_t>(m_heaps.size());
+	}
+
+	/// <summary>
+	/// Get budget and current usage of a heap
+	/// </summary>
+	/// <param name="heapIndex"></param>
+	/// <returns></returns>
+	MemoryHeapBudget MemoryBudget::getHeapBudget(uint32_t heapIndex) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		MemoryHeapBudget heap = m_heaps[heapIndex];
+		heap.usage = getUsage(heapIndex);
+		return heap;
+	}
+
+	/// <summary>
+	/// Get allocations of a category
+	/// </summary>
+	/// <param name="category">MEMORY_CATEGORY_*</param>
+	/// <returns></returns>
+	MemoryCategoryStats MemoryBudget::getCategoryStats(int category) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_categories[category];
+	}
+
+	/// <summary>
+	/// Check if budgets come from the driver
+	/// </summary>
+	/// <returns></returns>
+	bool MemoryBudget::hasBudgetExtension() const
+	{
+		return m_budgetExtension;
+	}
+
+	/// <summary>
+	/// Print heap budgets and categories in the console
+	/// </summary>
+	void MemoryBudget::printBudget() const
+	{
+		const char* categoryNames[MEMORY_CATEGORY_COUNT] = { "Vertex", "Index", "Texture", "Staging", "Render target" };
+
+		std::cout << "GPU Memory Budget" << (m_budgetExtension ? " (driver)" : " (heap size heuristic)") << std::endl;
+		for (uint32_t i = 0; i < getHeapCount(); i++) {
+			MemoryHeapBudget heap = getHeapBudget(i);
+			std::cout << "--Heap " << i << (heap.deviceLocal ? " device local" : " host") << " : " << heap.usage / (1024 * 1024) << " / " << heap.budget / (1024 * 1024) << " MiB | " << heap.blockBytes / (1024 * 1024) << " MiB in blocks" << std::endl;
+		}
+		for (int category = 0; category < MEMORY_CATEGORY_COUNT; category++) {
+			MemoryCategoryStats stats = getCategoryStats(category);
+			std::cout << "--" << categoryNames[category] << " : " << stats.allocationCount << " | " << stats.bytes / 1024 << " KiB" << std::endl;
+		}
+		std::cout << std::endl;
+	}
+
+	/// <summary>
+	/// Usage of a heap : last driver usage and blocks allocated or freed since, lock must be held
+	/// </summary>
+	/// <param name="heapIndex"></param>
+	/// <returns></returns>
+	VkDeviceSize MemoryBudget::getUsage(uint32_t heapIndex) const
+	{
+		const MemoryHeapBudget& heap = m_heaps[heapIndex];
+		if (heap.blockBytes >= m_blockBytesAtUpdate[heapIndex])
+			return heap.usage + (heap.blockBytes - m_blockBytesAtUpdate[heapIndex]);
+
+		VkDeviceSize freed = m_blockBytesAtUpdate[heapIndex] - heap.blockBytes;
+		return heap.usage > freed ? heap.usage - freed : 0;
+	}
+}
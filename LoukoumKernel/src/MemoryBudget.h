@@ -0,0 +1,99 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+namespace Loukoum
+{
+	//Memory categories : what an allocation is used for
+	constexpr int MEMORY_CATEGORY_VERTEX = 0;
+	constexpr int MEMORY_CATEGORY_INDEX = 1;
+	constexpr int MEMORY_CATEGORY_TEXTURE = 2;
+	constexpr int MEMORY_CATEGORY_STAGING = 3;
+	constexpr int MEMORY_CATEGORY_RENDER_TARGET = 4;
+	constexpr int MEMORY_CATEGORY_COUNT = 5;
+
+	//Memory priorities : low priority resources are evicted or refused first
+	constexpr int MEMORY_PRIORITY_LOW = 0;
+	constexpr int MEMORY_PRIORITY_NORMAL = 1;
+	constexpr int MEMORY_PRIORITY_HIGH = 2;
+
+	/// <summary>
+	/// Budget and usage of a memory heap, in bytes
+	/// </summary>
+	struct MemoryHeapBudget {
+		VkDeviceSize size = 0;
+		bool deviceLocal = false;
+
+		//Memory the process can use before the driver starts paging
+		VkDeviceSize budget = 0;
+
+		//Memory used by the process, other allocators included when the driver reports it
+		VkDeviceSize usage = 0;
+
+		//Memory of the allocator blocks in this heap
+		VkDeviceSize blockBytes = 0;
+	};
+
+	/// <summary>
+	/// Allocations of a category
+	/// </summary>
+	struct MemoryCategoryStats {
+		uint32_t allocationCount = 0;
+		VkDeviceSize bytes = 0;
+	};
+
+	/// <summary>
+	/// Memory Budget : heap budgets from VK_EXT_memory_budget, or from heap sizes, and usage per category
+	/// </summary>
+	class MemoryBudget
+	{
+	public:
+		MemoryBudget(VkPhysicalDevice physicalDevice, bool budgetExtension);
+
+		//Query heap budgets, once per frame
+		void update();
+
+		//Tracking, called by the allocator
+		void addBlock(uint32_t heapIndex, VkDeviceSize size);
+		void removeBlock(uint32_t heapIndex, VkDeviceSize size);
+		void addAllocation(int category, VkDeviceSize size);
+		void removeAllocation(int category, VkDeviceSize size);
+
+		//Budget checks
+		bool fits(uint32_t heapIndex, VkDeviceSize size, int priority, VkDeviceSize released = 0) const;
+
+		//Getters
+		uint32_t getHeapCount() const;
+		MemoryHeapBudget getHeapBudget(uint32_t heapIndex) const;
+		MemoryCategoryStats getCategoryStats(int category) const;
+		bool hasBudgetExtension() const;
+		void printBudget() const;
+
+		//Share of the budget each priority may fill, high priority may use it all
+		static constexpr float LOW_PRIORITY_LIMIT = 0.8f;
+		static constexpr float NORMAL_PRIORITY_LIMIT = 0.95f;
+
+		//Share of a heap used as budget without VK_EXT_memory_budget
+		static constexpr float HEURISTIC_BUDGET = 0.8f;
+
+	private:
+		VkDeviceSize getUsage(uint32_t heapIndex) const;
+
+		VkPhysicalDevice m_physicalDevice;
+		bool m_budgetExtension;
+		VkPhysicalDeviceMemoryProperties m_memoryProperties;
+
+		//Heaps : driver usage is only known at update, blocks allocated since are added to it
+		std::vector<MemoryHeapBudget> m_heaps;
+		std::vector<VkDeviceSize> m_blockBytesAtUpdate;
+
+		MemoryCategoryStats m_categories[MEMORY_CATEGORY_COUNT];
+		mutable std::mutex m_mutex;
+	};
+}
@@ -0,0 +1,224 @@
+#include "MeshFile.h"
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Open and map a mesh file, read only
+	/// </summary>
+	/// <param name="filename">Mesh file path</param>
+	MeshFile::MeshFile(const std::string& filename)
+	{
+		m_data = nullptr;
+		m_size = 0;
+		m_file = nullptr;
+		m_mapping = nullptr;
+
+	#ifdef _WIN32
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("Failed to open mesh file " + filename);
+		m_file = file;
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+		m_size = (size_t)size.QuadPart;
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			m_mapping = mapping;
+			m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+	#else
+		int file = open(filename.c_str(), O_RDONLY);
+		if (file < 0)
+			throw std::runtime_error("Failed to open mesh file " + filename);
+		m_file = reinterpret_cast<void*>(static_cast<intptr_t>(file));
+
+		struct stat info;
+		fstat(file, &info);
+		m_size = (size_t)info.st_size;
+
+		void* data = m_size > 0 ? mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+		if (data != MAP_FAILED) {
+			//Streams are read once, front to back
+			madvise(data, m_size, MADV_SEQUENTIAL);
+			m_data = static_cast<const uint8_t*>(data);
+		}
+	#endif
+
+		if (m_data == nullptr) {
+			close();
+			throw std::runtime_error("Failed to map mesh file " + filename);
+		}
+
+		try {
+			validate();
+		}
+		catch (...) {
+			close();
+			throw;
+		}
+	}
+
+	/// <summary>
+	/// Destructor
+	/// </summary>
+	MeshFile::~MeshFile()
+	{
+		close();
+	}
+
+	/// <summary>
+	/// Unmap and close the file
+	/// </summary>
+	void MeshFile::close()
+	{
+	#ifdef _WIN32
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr)
+			CloseHandle(static_cast<HANDLE>(m_mapping));
+		if (m_file != nullptr)
+			CloseHandle(static_cast<HANDLE>(m_file));
+	#else
+		if (m_data != nullptr)
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+		if (m_file != nullptr)
+			::close(static_cast<int>(reinterpret_cast<intptr_t>(m_file)));
+	#endif
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = nullptr;
+	}
+
+	/// <summary>
+	/// Get file header
+	/// </summary>
+	/// <returns></returns>
+	const MeshFileHeader& MeshFile::getHeader() const
+	{
+		return *reinterpret_cast<const MeshFileHeader*>(m_data);
+	}
+
+	/// <summary>
+	/// Get vertex stream
+	/// </summary>
+	/// <returns>vertexCount vertices in the vertexFormat layout</returns>
+	const void* MeshFile::getVertexData() const
+	{
+		return m_data + getHeader().vertexOffset;
+	}
+
+	/// <summary>
+	/// Get index stream
+	/// </summary>
+	/// <returns>indexCount indices</returns>
+	const uint32_t* MeshFile::getIndexData() const
+	{
+		return reinterpret_cast<const uint32_t*>(m_data + getHeader().indexOffset);
+	}
+
+	/// <summary>
+	/// Get LOD table
+	/// </summary>
+	/// <returns>lodCount LODs</returns>
+	const MeshFileLod* MeshFile::getLods() const
+	{
+		return reinterpret_cast<const MeshFileLod*>(m_data + getHeader().lodOffset);
+	}
+
+	/// <summary>
+	/// Write a mesh file
+	/// </summary>
+	/// <param name="filename">Mesh file path</param>
+	/// <param name="format">Vertex format of vertexData</param>
+	/// <param name="bounds">Dequantization bounds</param>
+	/// <param name="vertexData">Vertices in the format layout</param>
+	/// <param name="vertexCount">Number of vertices</param>
+	/// <param name="indices">Index stream of all LODs</param>
+	/// <param name="lods">LOD table, finest first</param>
+	void MeshFile::write(const std::string& filename, int format, const VertexBounds& bounds, const void* vertexData, uint64_t vertexCount, const std::vector<uint32_t>& indices, const std::vector<MeshFileLod>& lods)
+	{
+		auto align = [](uint64_t offset) { return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT; };
+
+		//Layout : header, LOD table, vertex stream, index stream
+		MeshFileHeader header{};
+		memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+		header.version = MESH_FILE_VERSION;
+		header.vertexFormat = format;
+		header.vertexStride = VertexFormat::getStride(format);
+		header.vertexCount = vertexCount;
+		header.indexCount = indices.size();
+		header.lodCount = static_cast<uint32_t>(lods.size());
+		header.bounds = bounds;
+		header.lodOffset = align(sizeof(MeshFileHeader));
+		header.vertexOffset = align(header.lodOffset + lods.size() * sizeof(MeshFileLod));
+		header.indexOffset = align(header.vertexOffset + vertexCount * header.vertexStride);
+
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			throw std::runtime_error("Failed to create mesh file " + filename);
+
+		//Zero padding up to an offset
+		auto pad = [&file](uint64_t offset) {
+			static const char zeros[MESH_FILE_ALIGNMENT] = {};
+			file.write(zeros, offset - (uint64_t)file.tellp());
+		};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		pad(header.lodOffset);
+		file.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(MeshFileLod));
+		pad(header.vertexOffset);
+		file.write(static_cast<const char*>(vertexData), vertexCount * header.vertexStride);
+		pad(header.indexOffset);
+		file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+
+		if (!file.good())
+			throw std::runtime_error("Failed to write mesh file " + filename);
+	}
+
+	/// <summary>
+	/// Check header and stream ranges against file size
+	/// </summary>
+	void MeshFile::validate()
+	{
+		if (m_size < sizeof(MeshFileHeader))
+			throw std::runtime_error("Failed to read mesh file : file too small");
+
+		const MeshFileHeader& header = getHeader();
+		if (memcmp(header.magic, MESH_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_FILE_VERSION)
+			throw std::runtime_error("Failed to read mesh file : unknown format or version");
+		if (header.vertexStride != VertexFormat::getStride(header.vertexFormat))
+			throw std::runtime_error("Failed to read mesh file : vertex stride doesn't match format");
+
+		//Streams are aligned for direct reads
+		if (header.vertexOffset % MESH_FILE_ALIGNMENT != 0 || header.indexOffset % MESH_FILE_ALIGNMENT != 0 || header.lodOffset % MESH_FILE_ALIGNMENT != 0)
+			throw std::runtime_error("Failed to read mesh file : stream not aligned");
+
+		//Counts are bounded by the file size before computing stream ends, products can't overflow
+		auto fits = [this](uint64_t offset, uint64_t count, uint64_t elementSize) {
+			return offset <= m_size && count <= (m_size - offset) / elementSize;
+		};
+		if (!fits(header.vertexOffset, header.vertexCount, header.vertexStride) || !fits(header.indexOffset, header.indexCount, sizeof(uint32_t)) || !fits(header.lodOffset, header.lodCount, sizeof(MeshFileLod)))
+			throw std::runtime_error("Failed to read mesh file : stream out of file");
+
+		//LOD ranges must be in the index stream
+		const MeshFileLod* lods = getLods();
+		for (uint32_t i = 0; i < header.lodCount; i++) {
+			if ((uint64_t)lods[i].firstIndex + lods[i].indexCount > header.indexCount || lods[i].indexCount % 3 != 0)
+				throw std::runtime_error("Failed to read mesh file : LOD out of index stream");
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+
+#include "VertexFormat.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Mesh file header, at offset 0
+	/// Streams start on MESH_FILE_ALIGNMENT boundaries and are stored as the GPU reads them
+	/// </summary>
+	struct MeshFileHeader {
+		char magic[4];
+		uint32_t version;
+
+		//Vertex stream, in vertexFormat layout
+		int32_t vertexFormat;
+		uint32_t vertexStride;
+		uint64_t vertexCount;
+		uint64_t vertexOffset;
+
+		//Index stream : uint32_t triangle list, all LODs one after the other
+		uint64_t indexCount;
+		uint64_t indexOffset;
+
+		//LOD table : MeshFileLod array, finest first
+		uint32_t lodCount;
+		uint32_t reserved;
+		uint64_t lodOffset;
+
+		//Dequantization bounds, identity for the float format
+		VertexBounds bounds;
+	};
+
+	/// <summary>
+	/// Level of detail : range of the index stream
+	/// </summary>
+	struct MeshFileLod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+
+		//Largest position error of this LOD
+		float error;
+		uint32_t reserved;
+	};
+
+	constexpr char MESH_FILE_MAGIC[4] = { 'L', 'K', 'M', 'S' };
+	constexpr uint32_t MESH_FILE_VERSION = 1;
+	constexpr uint64_t MESH_FILE_ALIGNMENT = 16;
+
+	/// <summary>
+	/// Mesh File : memory mapped binary mesh, streams are used in place without parsing
+	/// </summary>
+	class MeshFile
+	{
+	public:
+		MeshFile(const std::string& filename);
+		~MeshFile();
+
+		MeshFile(const MeshFile&) = delete;
+		MeshFile& operator=(const MeshFile&) = delete;
+
+		//Getters, pointers are valid while the file is open
+		const MeshFileHeader& getHeader() const;
+		const void* getVertexData() const;
+		const uint32_t* getIndexData() const;
+		const MeshFileLod* getLods() const;
+
+		//Writing, vertexData is in the format layout
+		static void write(const std::string& filename, int format, const VertexBounds& bounds, const void* vertexData, uint64_t vertexCount, const std::vector<uint32_t>& indices, const std::vector<MeshFileLod>& lods);
+
+	private:
+		void validate();
+		void close();
+
+		//Mapping
+		const uint8_t* m_data;
+		size_t m_size;
+		void* m_file;
+		void* m_mapping;
+	};
+}
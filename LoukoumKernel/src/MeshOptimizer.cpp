@@ -0,0 +1,301 @@
+#include "MeshOptimizer.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Reorder triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007)
+	/// Fans around the vertex that stays longest in cache, jumps to a recent vertex on dead ends
+	/// </summary>
+	/// <param name="indices">Triangle list indices, reordered in place</param>
+	/// <param name="vertexCount">Number of vertices</param>
+	/// <param name="cacheSize">Simulated cache size</param>
+	void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		//Vertex to triangles adjacency
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (uint32_t index : indices)
+			liveTriangles[index]++;
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		//Cache time stamps : a vertex is in cache while time - stamp <= cache size
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		int64_t fanning = indices[0];
+		size_t cursor = 0;
+		while (fanning >= 0) {
+			candidates.clear();
+
+			//Emit all triangles around the fanning vertex
+			for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++) {
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle])
+					continue;
+
+				for (int c = 0; c < 3; c++) {
+					uint32_t v = indices[triangle * 3 + c];
+					result.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+					if (time - cacheTimestamps[v] > cacheSize)
+						cacheTimestamps[v] = time++;
+				}
+				emitted[triangle] = true;
+			}
+
+			//Next fanning vertex : the oldest candidate still in cache after its remaining triangles
+			fanning = -1;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates) {
+				if (liveTriangles[v] == 0)
+					continue;
+
+				int64_t priority = 0;
+				if (time - cacheTimestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+					priority = time - cacheTimestamps[v];
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					fanning = v;
+				}
+			}
+
+			//Dead end : most recent vertex with triangles left, else next vertex in input order
+			while (fanning < 0 && !deadEnds.empty()) {
+				uint32_t v = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[v] > 0)
+					fanning = v;
+			}
+			while (fanning < 0 && cursor < vertexCount) {
+				if (liveTriangles[cursor] > 0)
+					fanning = static_cast<int64_t>(cursor);
+				cursor++;
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	/// <summary>
+	/// Reorder clusters of triangles so outward facing clusters are drawn first (Sander et al. 2007)
+	/// Run after optimizeVertexCache : clusters are cut where restarting the cache costs little
+	/// </summary>
+	/// <param name="indices">Triangle list indices, reordered in place</param>
+	/// <param name="vertices">Mesh vertices</param>
+	/// <param name="threshold">Allowed ACMR increase, 1.05 for 5%</param>
+	/// <param name="cacheSize">Simulated cache size</param>
+	void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold, uint32_t cacheSize)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		std::vector<size_t> clusters = findClusters(indices, vertices.size(), threshold, cacheSize);
+		if (clusters.size() <= 1)
+			return;
+
+		//Mesh centroid weighted by triangle area
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (size_t t = 0; t < triangleCount; t++) {
+			const glm::vec3& p0 = vertices[indices[t * 3]].pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+			float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+			meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+			meshArea += area;
+		}
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		//Sort key : how much the cluster faces away from the mesh center
+		std::vector<float> sortKeys(clusters.size());
+		for (size_t c = 0; c < clusters.size(); c++) {
+			size_t begin = clusters[c];
+			size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+			glm::vec3 centroid(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+			for (size_t t = begin; t < end; t++) {
+				const glm::vec3& p0 = vertices[indices[t * 3]].pos;
+				const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+				const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+				glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+				float faceArea = glm::length(faceNormal);
+				centroid += (p0 + p1 + p2) * (faceArea / 3.0f);
+				normal += faceNormal;
+				area += faceArea;
+			}
+			if (area > 0.0f)
+				centroid /= area;
+
+			float normalLength = glm::length(normal);
+			sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+		}
+
+		std::vector<size_t> order(clusters.size());
+		for (size_t c = 0; c < order.size(); c++)
+			order[c] = c;
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		//Copy clusters in the new order
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (size_t c : order) {
+			size_t begin = clusters[c] * 3;
+			size_t end = c + 1 < clusters.size() ? clusters[c + 1] * 3 : indices.size();
+			result.insert(result.end(), indices.begin() + begin, indices.begin() + end);
+		}
+
+		indices.swap(result);
+	}
+
+	/// <summary>
+	/// Sort vertices by first use in the index buffer and rewrite indices
+	/// Unused vertices are removed
+	/// </summary>
+	/// <param name="vertices">Mesh vertices, reordered in place</param>
+	/// <param name="indices">Triangle list indices, rewritten in place</param>
+	/// <returns>New index of every old vertex, UINT32_MAX for removed vertices</returns>
+	std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+		std::vector<Vertex> result;
+		result.reserve(vertices.size());
+
+		for (uint32_t& index : indices) {
+			if (remap[index] == UINT32_MAX) {
+				remap[index] = static_cast<uint32_t>(result.size());
+				result.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices.swap(result);
+		return remap;
+	}
+
+	/// <summary>
+	/// Simplify by vertex clustering : vertices in the same grid cell collapse on the first one, collapsed triangles are removed
+	/// The simplified triangles use the same vertices, LODs can share one vertex buffer
+	/// </summary>
+	/// <param name="indices">Triangle list indices</param>
+	/// <param name="vertices">Mesh vertices</param>
+	/// <param name="cellSize">Grid cell size, largest position error</param>
+	/// <returns>Triangle list indices</returns>
+	std::vector<uint32_t> MeshOptimizer::simplifyClustering(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float cellSize)
+	{
+		//Representative vertex of every cell
+		std::vector<uint32_t> remap(vertices.size());
+		std::unordered_map<uint64_t, uint32_t> cells;
+		for (uint32_t v = 0; v < vertices.size(); v++) {
+			glm::ivec3 cell = glm::ivec3(glm::floor(vertices[v].pos / cellSize));
+			uint64_t key = (uint64_t(uint32_t(cell.x) & 0x1FFFFF) << 42) | (uint64_t(uint32_t(cell.y) & 0x1FFFFF) << 21) | uint64_t(uint32_t(cell.z) & 0x1FFFFF);
+			remap[v] = cells.emplace(key, v).first->second;
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			uint32_t a = remap[indices[i]];
+			uint32_t b = remap[indices[i + 1]];
+			uint32_t c = remap[indices[i + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+			result.push_back(a);
+			result.push_back(b);
+			result.push_back(c);
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Simulate a FIFO post-transform cache
+	/// </summary>
+	/// <param name="indices">Triangle list indices</param>
+	/// <param name="vertexCount">Number of vertices</param>
+	/// <param name="cacheSize">Simulated cache size</param>
+	/// <returns></returns>
+	VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats;
+		if (indices.empty() || vertexCount == 0)
+			return stats;
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		for (uint32_t index : indices) {
+			if (time - cacheTimestamps[index] > cacheSize) {
+				cacheTimestamps[index] = time++;
+				stats.transformedVertices++;
+			}
+		}
+
+		stats.acmr = static_cast<float>(stats.transformedVertices) / static_cast<float>(indices.size() / 3);
+		stats.atvr = static_cast<float>(stats.transformedVertices) / static_cast<float>(vertexCount);
+		return stats;
+	}
+
+	/// <summary>
+	/// Cut the index buffer in clusters where the cluster ACMR with a cold cache stays under threshold * mesh ACMR
+	/// </summary>
+	/// <param name="indices">Triangle list indices</param>
+	/// <param name="vertexCount">Number of vertices</param>
+	/// <param name="threshold">Allowed ACMR increase</param>
+	/// <param name="cacheSize">Simulated cache size</param>
+	/// <returns>First triangle of every cluster</returns>
+	std::vector<size_t> MeshOptimizer::findClusters(const std::vector<uint32_t>& indices, size_t vertexCount, float threshold, uint32_t cacheSize)
+	{
+		float meshAcmr = analyzeVertexCache(indices, vertexCount, cacheSize).acmr;
+		size_t triangleCount = indices.size() / 3;
+
+		std::vector<size_t> clusters;
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		uint32_t clusterMisses = 0;
+		size_t clusterStart = 0;
+
+		clusters.push_back(0);
+		for (size_t t = 0; t < triangleCount; t++) {
+			for (int c = 0; c < 3; c++) {
+				uint32_t v = indices[t * 3 + c];
+				if (time - cacheTimestamps[v] > cacheSize) {
+					cacheTimestamps[v] = time++;
+					clusterMisses++;
+				}
+			}
+
+			//Close the cluster, next one starts with a cold cache
+			float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(t + 1 - clusterStart);
+			if (t + 1 < triangleCount && clusterAcmr <= meshAcmr * threshold) {
+				clusterStart = t + 1;
+				clusterMisses = 0;
+				time += cacheSize + 1;
+				clusters.push_back(clusterStart);
+			}
+		}
+
+		return clusters;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "VertexFormat.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Post-transform vertex cache statistics of an index buffer
+	/// </summary>
+	struct VertexCacheStats {
+		uint32_t transformedVertices = 0;
+
+		//Average Cache Miss Ratio : transformed vertices per triangle, 0.5 at best, 3 at worst
+		float acmr = 0.0f;
+
+		//Average Transformed Vertex Ratio : transformed vertices per vertex, 1 at best
+		float atvr = 0.0f;
+	};
+
+	/// <summary>
+	/// Mesh Optimizer : reorders triangle list indices and vertices before upload
+	/// </summary>
+	class MeshOptimizer
+	{
+	public:
+		//Triangle order : Tipsify vertex cache reorder, then overdraw aware cluster sort
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+		static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = DEFAULT_OVERDRAW_THRESHOLD, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+		//Vertex order : vertices sorted by first use, returns old to new index table
+		static std::vector<uint32_t> optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		//Level of detail : vertices snapped on a grid, returns indices of the simplified triangles
+		static std::vector<uint32_t> simplifyClustering(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float cellSize);
+
+		//Analysis with a FIFO cache
+		static VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+		//Cache size of recent GPUs, in vertices
+		static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+
+		//Clusters may be this much worse than the whole mesh ACMR
+		static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+	private:
+		static std::vector<size_t> findClusters(const std::vector<uint32_t>& indices, size_t vertexCount, float threshold, uint32_t cacheSize);
+	};
+}
@@ -0,0 +1,185 @@
+#include "PipelineCache.h"
+
+namespace Loukoum
+{
+	//VkPipelineCacheHeaderVersionOne : header size, version, vendor ID, device ID, cache UUID
+	static constexpr size_t CACHE_HEADER_SIZE = 16 + VK_UUID_SIZE;
+
+	/// <summary>
+	/// Pipeline Cache constructor : create the cache from the file when it fits this device
+	/// </summary>
+	/// <param name="physicalDevice">GPU the cache data must come from</param>
+	/// <param name="device"></param>
+	/// <param name="filename">Cache file, created on save if missing</param>
+	PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& filename)
+	{
+		m_device = device;
+		m_filename = filename;
+		m_autoSaveInterval = 0.0;
+		m_lastSave = std::chrono::steady_clock::now();
+		vkGetPhysicalDeviceProperties(physicalDevice, &m_deviceProperties);
+
+		std::vector<char> data = load();
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = data.size();
+		cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+		if (vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_cache) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create pipeline cache");
+		}
+
+		m_loadedSize = data.size();
+		m_savedSize = data.size();
+	}
+
+	/// <summary>
+	/// Pipeline Cache destructor : save and destroy, no pipeline may be in creation
+	/// </summary>
+	PipelineCache::~PipelineCache()
+	{
+		save();
+		vkDestroyPipelineCache(m_device, m_cache, nullptr);
+	}
+
+	/// <summary>
+	/// Write the cache data to the file if pipelines were added since the last save
+	/// The data goes to a temporary file first : a crash never leaves a truncated cache
+	/// </summary>
+	/// <returns>true if the file was written</returns>
+	bool PipelineCache::save()
+	{
+		m_lastSave = std::chrono::steady_clock::now();
+
+		size_t size = getDataSize();
+		if (size == 0 || size == m_savedSize)
+			return false;
+
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(m_device, m_cache, &size, data.data()) != VK_SUCCESS) {
+			std::cout << "Loukoum : failed to get pipeline cache data" << std::endl;
+			return false;
+		}
+		data.resize(size);
+
+		std::string tempFilename = m_filename + ".tmp";
+		{
+			std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+			file.write(data.data(), data.size());
+			if (!file.good()) {
+				std::cout << "Loukoum : failed to write pipeline cache " << tempFilename << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempFilename, m_filename, error);
+		if (error) {
+			std::cout << "Loukoum : failed to replace pipeline cache " << m_filename << " : " << error.message() << std::endl;
+			return false;
+		}
+
+		m_savedSize = data.size();
+		return true;
+	}
+
+	/// <summary>
+	/// Set the time between two periodic saves, a crash then loses at most this much compile time
+	/// </summary>
+	/// <param name="seconds">0 to only save on shutdown</param>
+	void PipelineCache::setAutoSaveInterval(double seconds)
+	{
+		m_autoSaveInterval = seconds;
+	}
+
+	/// <summary>
+	/// Periodic save, called once per frame
+	/// </summary>
+	void PipelineCache::update()
+	{
+		if (m_autoSaveInterval <= 0.0)
+			return;
+
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_lastSave).count();
+		if (elapsed >= m_autoSaveInterval)
+			save();
+	}
+
+	/// <summary>
+	/// Get Vulkan pipeline cache, given to every pipeline creation
+	/// </summary>
+	/// <returns></returns>
+	VkPipelineCache PipelineCache::getCache() const
+	{
+		return m_cache;
+	}
+
+	/// <summary>
+	/// Get size of the data loaded from disk, 0 on a cold start
+	/// </summary>
+	/// <returns></returns>
+	size_t PipelineCache::getLoadedSize() const
+	{
+		return m_loadedSize;
+	}
+
+	/// <summary>
+	/// Read the cache file, empty when missing or made for another device or driver
+	/// </summary>
+	/// <returns></returns>
+	std::vector<char> PipelineCache::load()
+	{
+		std::ifstream file(m_filename, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			std::cout << "Loukoum : no pipeline cache, cold start" << std::endl;
+			return {};
+		}
+
+		std::vector<char> data((size_t)file.tellg());
+		file.seekg(0);
+		file.read(data.data(), data.size());
+		if (!file.good() || !isCompatible(data)) {
+			std::cout << "Loukoum : pipeline cache " << m_filename << " ignored, made by another device or driver" << std::endl;
+			return {};
+		}
+
+		std::cout << "Loukoum : pipeline cache loaded, " << data.size() / 1024 << " KiB" << std::endl;
+		return data;
+	}
+
+	/// <summary>
+	/// Check the cache header against this device and driver
+	/// </summary>
+	/// <param name="data">Cache file data</param>
+	/// <returns></returns>
+	bool PipelineCache::isCompatible(const std::vector<char>& data) const
+	{
+		if (data.size() < CACHE_HEADER_SIZE)
+			return false;
+
+		uint32_t header[4];
+		memcpy(header, data.data(), sizeof(header));
+		uint32_t headerSize = header[0];
+		uint32_t headerVersion = header[1];
+		uint32_t vendorID = header[2];
+		uint32_t deviceID = header[3];
+
+		return headerSize >= CACHE_HEADER_SIZE && headerSize <= data.size()
+			&& headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& vendorID == m_deviceProperties.vendorID
+			&& deviceID == m_deviceProperties.deviceID
+			&& memcmp(data.data() + sizeof(header), m_deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	/// <summary>
+	/// Get size of the driver cache data
+	/// </summary>
+	/// <returns></returns>
+	size_t PipelineCache::getDataSize() const
+	{
+		size_t size = 0;
+		if (vkGetPipelineCacheData(m_device, m_cache, &size, nullptr) != VK_SUCCESS)
+			return 0;
+		return size;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Pipeline Cache : one VkPipelineCache shared by all pipeline creations, kept on disk between runs
+	/// The file is the driver cache data, used only if its header matches the vendor, device and cache UUID
+	/// </summary>
+	class PipelineCache
+	{
+	public:
+		PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& filename = DEFAULT_FILENAME);
+		~PipelineCache();
+
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+
+		//Save to disk, only when the driver data changed
+		bool save();
+
+		//Periodic save, 0 seconds to only save on shutdown
+		void setAutoSaveInterval(double seconds);
+		void update();
+
+		//Getters
+		VkPipelineCache getCache() const;
+		size_t getLoadedSize() const;
+
+		//Cache file in the working directory
+		static constexpr const char* DEFAULT_FILENAME = "pipeline.cache";
+
+	private:
+		std::vector<char> load();
+		bool isCompatible(const std::vector<char>& data) const;
+		size_t getDataSize() const;
+
+		VkDevice m_device;
+		VkPipelineCache m_cache;
+		VkPhysicalDeviceProperties m_deviceProperties;
+		std::string m_filename;
+
+		//Size of the data on disk, the cache only grows
+		size_t m_loadedSize;
+		size_t m_savedSize;
+
+		double m_autoSaveInterval;
+		std::chrono::steady_clock::time_point m_lastSave;
+	};
+}
@@ -0,0 +1,222 @@
+#include "PipelineLayoutCache.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Compare sorted bindings of a set
+	/// </summary>
+	/// <param name="a"></param>
+	/// <param name="b"></param>
+	/// <returns></returns>
+	static bool equalBindings(const std::vector<VkDescriptorSetLayoutBinding>& a, const std::vector<VkDescriptorSetLayoutBinding>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++) {
+			if (a[i].binding != b[i].binding || a[i].descriptorType != b[i].descriptorType
+				|| a[i].descriptorCount != b[i].descriptorCount || a[i].stageFlags != b[i].stageFlags)
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Pipeline Layout Cache constructor
+	/// </summary>
+	/// <param name="device"></param>
+	PipelineLayoutCache::PipelineLayoutCache(VkDevice device)
+	{
+		m_device = device;
+		m_requestCount = 0;
+		m_cacheHits = 0;
+	}
+
+	/// <summary>
+	/// Pipeline Layout Cache destructor : no command buffer using the layouts may be pending
+	/// </summary>
+	PipelineLayoutCache::~PipelineLayoutCache()
+	{
+		for (auto& layout : m_layouts)
+			vkDestroyPipelineLayout(m_device, layout.second.info.layout, nullptr);
+		for (auto& setLayout : m_setLayouts)
+			vkDestroyDescriptorSetLayout(m_device, setLayout.second.setLayout, nullptr);
+	}
+
+	/// <summary>
+	/// Get the layout of the stages of a pipeline : bindings and push constants of all stages are merged
+	/// </summary>
+	/// <param name="interfaces">Interface of each stage</param>
+	/// <returns></returns>
+	PipelineLayoutInfo PipelineLayoutCache::getLayout(const std::vector<ShaderInterface>& interfaces)
+	{
+		//Merge the stages : a binding used by several stages is visible to all of them
+		std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+		VkShaderStageFlags pushConstantStages = 0;
+		uint32_t pushConstantSize = 0;
+		for (const ShaderInterface& shaderInterface : interfaces) {
+			for (const ShaderBinding& binding : shaderInterface.bindings) {
+				if (sets.size() <= binding.set)
+					sets.resize(binding.set + 1);
+
+				std::vector<VkDescriptorSetLayoutBinding>& set = sets[binding.set];
+				auto found = std::find_if(set.begin(), set.end(), [&binding](const VkDescriptorSetLayoutBinding& other) {
+					return other.binding == binding.binding;
+				});
+				if (found == set.end()) {
+					VkDescriptorSetLayoutBinding layoutBinding{};
+					layoutBinding.binding = binding.binding;
+					layoutBinding.descriptorType = binding.type;
+					layoutBinding.descriptorCount = binding.count;
+					layoutBinding.stageFlags = shaderInterface.stage;
+					layoutBinding.pImmutableSamplers = nullptr;
+					set.push_back(layoutBinding);
+				}
+				else if (found->descriptorType != binding.type || found->descriptorCount != binding.count) {
+					throw std::runtime_error("Failed to merge shader bindings, set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + " differs between stages");
+				}
+				else {
+					found->stageFlags |= shaderInterface.stage;
+				}
+			}
+
+			if (shaderInterface.pushConstantSize > 0) {
+				pushConstantStages |= shaderInterface.stage;
+				pushConstantSize = std::max(pushConstantSize, shaderInterface.pushConstantSize);
+			}
+		}
+
+		uint64_t hash = Utils::HASH_SEED;
+		for (std::vector<VkDescriptorSetLayoutBinding>& set : sets) {
+			std::sort(set.begin(), set.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+				return a.binding < b.binding;
+			});
+			hash = Utils::hashValue(hash, set.size());
+			for (const VkDescriptorSetLayoutBinding& binding : set) {
+				hash = Utils::hashValue(hash, binding.binding);
+				hash = Utils::hashValue(hash, (uint64_t)binding.descriptorType);
+				hash = Utils::hashValue(hash, binding.descriptorCount);
+				hash = Utils::hashValue(hash, binding.stageFlags);
+			}
+		}
+		hash = Utils::hashValue(hash, pushConstantStages);
+		hash = Utils::hashValue(hash, pushConstantSize);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requestCount++;
+		//Same hash : the content is compared, a collision gets its own layout
+		auto range = m_layouts.equal_range(hash);
+		for (auto found = range.first; found != range.second; found++) {
+			const PipelineLayoutEntry& entry = found->second;
+			if (entry.info.pushConstantStages != pushConstantStages || entry.info.pushConstantSize != pushConstantSize || entry.sets.size() != sets.size())
+				continue;
+			bool equal = true;
+			for (size_t i = 0; i < sets.size() && equal; i++)
+				equal = equalBindings(entry.sets[i], sets[i]);
+			if (equal) {
+				m_cacheHits++;
+				return entry.info;
+			}
+		}
+
+		PipelineLayoutInfo info;
+		for (const std::vector<VkDescriptorSetLayoutBinding>& set : sets)
+			info.setLayouts.push_back(getSetLayout(set));
+		info.pushConstantStages = pushConstantStages;
+		info.pushConstantSize = pushConstantSize;
+
+		//Push constant range shared by the stages using it
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = pushConstantStages;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = pushConstantSize;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(info.setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = info.setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &info.layout) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create Pipeline layout");
+		}
+
+		PipelineLayoutEntry entry;
+		entry.info = info;
+		entry.sets = sets;
+		m_layouts.emplace(hash, entry);
+		return info;
+	}
+
+	/// <summary>
+	/// Get set layouts and push constants of a layout created by the cache
+	/// </summary>
+	/// <param name="layout"></param>
+	/// <returns></returns>
+	PipelineLayoutInfo PipelineLayoutCache::getLayoutInfo(VkPipelineLayout layout)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (const auto& entry : m_layouts) {
+			if (entry.second.info.layout == layout)
+				return entry.second.info;
+		}
+		throw std::runtime_error("Failed to get pipeline layout, not created by the cache");
+	}
+
+	/// <summary>
+	/// Get number of pipeline layouts
+	/// </summary>
+	/// <returns></returns>
+	size_t PipelineLayoutCache::getLayoutCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_layouts.size();
+	}
+
+	/// <summary>
+	/// Print layouts created and requests served from the cache
+	/// </summary>
+	void PipelineLayoutCache::printStats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::cout << "Loukoum : layouts, " << m_layouts.size() << " pipeline layouts, " << m_setLayouts.size() << " set layouts, "
+			<< m_requestCount << " requests, " << m_cacheHits << " cache hits" << std::endl;
+	}
+
+	/// <summary>
+	/// Get the descriptor set layout of sorted bindings, created if missing, lock must be held
+	/// </summary>
+	/// <param name="bindings">Sorted by binding, empty for an unused set</param>
+	/// <returns></returns>
+	VkDescriptorSetLayout PipelineLayoutCache::getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		uint64_t hash = Utils::HASH_SEED;
+		for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+			hash = Utils::hashValue(hash, binding.binding);
+			hash = Utils::hashValue(hash, (uint64_t)binding.descriptorType);
+			hash = Utils::hashValue(hash, binding.descriptorCount);
+			hash = Utils::hashValue(hash, binding.stageFlags);
+		}
+
+		auto range = m_setLayouts.equal_range(hash);
+		for (auto found = range.first; found != range.second; found++) {
+			if (equalBindings(found->second.bindings, bindings))
+				return found->second.setLayout;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout;
+		if (vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create Descriptor set layout");
+		}
+		SetLayoutEntry entry;
+		entry.setLayout = setLayout;
+		entry.bindings = bindings;
+		m_setLayouts.emplace(hash, entry);
+		return setLayout;
+	}
+}
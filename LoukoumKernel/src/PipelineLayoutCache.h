@@ -0,0 +1,81 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+
+#include "ShaderReflection.h"
+#include "Utils.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Pipeline layout made from the interfaces of the shaders of a pipeline
+	/// </summary>
+	struct PipelineLayoutInfo {
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSetLayout> setLayouts;	//By set index, unused sets are empty layouts
+		VkShaderStageFlags pushConstantStages = 0;
+		uint32_t pushConstantSize = 0;
+	};
+
+	/// <summary>
+	/// Pipeline layout of the cache with the content it was made from, compared on hash hits
+	/// </summary>
+	struct PipelineLayoutEntry {
+		PipelineLayoutInfo info;
+		std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;	//Merged bindings by set index, sorted by binding
+	};
+
+	/// <summary>
+	/// Descriptor set layout of the cache with its bindings, compared on hash hits
+	/// </summary>
+	struct SetLayoutEntry {
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+	};
+
+	/// <summary>
+	/// Pipeline Layout Cache : descriptor set layouts and pipeline layouts generated from shader reflection
+	/// Layouts are created once per content, found by hash, and kept until shutdown, they are small and few
+	/// </summary>
+	class PipelineLayoutCache
+	{
+	public:
+		PipelineLayoutCache(VkDevice device);
+		~PipelineLayoutCache();
+
+		PipelineLayoutCache(const PipelineLayoutCache&) = delete;
+		PipelineLayoutCache& operator=(const PipelineLayoutCache&) = delete;
+
+		//Layout of the stages of a pipeline, throws if two stages declare a binding differently
+		PipelineLayoutInfo getLayout(const std::vector<ShaderInterface>& interfaces);
+
+		//Layout created by the cache
+		PipelineLayoutInfo getLayoutInfo(VkPipelineLayout layout);
+
+		//Stats
+		size_t getLayoutCount();
+		void printStats();
+
+	private:
+		VkDescriptorSetLayout getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+		VkDevice m_device;
+
+		//By hash of their content, colliding contents are kept side by side
+		std::unordered_multimap<uint64_t, SetLayoutEntry> m_setLayouts;
+		std::unordered_multimap<uint64_t, PipelineLayoutEntry> m_layouts;
+
+		//Stats
+		uint64_t m_requestCount;
+		uint64_t m_cacheHits;
+
+		std::mutex m_mutex;
+	};
+}
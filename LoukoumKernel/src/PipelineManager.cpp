@@ -0,0 +1,1035 @@
+#include "PipelineManager.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Load a device command, throws if missing
+	/// </summary>
+	/// <param name="device"></param>
+	/// <param name="name"></param>
+	/// <param name="function"></param>
+	template<typename T>
+	static void loadDeviceFunction(VkDevice device, const char* name, T& function)
+	{
+		function = reinterpret_cast<T>(vkGetDeviceProcAddr(device, name));
+		if (function == nullptr)
+			throw std::runtime_error(std::string("Failed to load device function ") + name);
+	}
+
+	/// <summary>
+	/// Create infos of a graphics pipeline, filled in place : the structures point to each other
+	/// </summary>
+	struct PipelineState {
+		VkPipelineShaderStageCreateInfo stages[2];
+		VkSpecializationInfo specializations[2];
+		VkVertexInputBindingDescription binding;
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		VkPipelineVertexInputStateCreateInfo vertexInput{};
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		VkPipelineViewportStateCreateInfo viewportState{};
+		VkPipelineRasterizationStateCreateInfo rasterizer{};
+		VkPipelineMultisampleStateCreateInfo multisampling{};
+		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+		VkPipelineColorBlendStateCreateInfo colorBlending{};
+		VkDynamicState dynamicStates[2];
+		VkPipelineDynamicStateCreateInfo dynamicState{};
+	};
+
+	/// <summary>
+	/// Fill the create infos of a description
+	/// </summary>
+	/// <param name="description"></param>
+	/// <param name="shaderLibrary">Modules of the shaders</param>
+	/// <param name="state"></param>
+	static void fillPipelineState(const PipelineDescription& description, ShaderLibrary* shaderLibrary, PipelineState& state)
+	{
+		state.stages[0] = shaderLibrary->getStage(description.vertexShader, VK_SHADER_STAGE_VERTEX_BIT);
+		state.stages[1] = shaderLibrary->getStage(description.fragmentShader, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+		//Specialization constants, the shaders keep their defaults without
+		const ShaderSpecialization* specializations[2] = { &description.vertexSpecialization, &description.fragmentSpecialization };
+		ShaderHandle shaders[2] = { description.vertexShader, description.fragmentShader };
+		for (int i = 0; i < 2; i++) {
+			if (specializations[i]->isEmpty())
+				continue;
+			specializations[i]->check(shaderLibrary->getInterface(shaders[i]));
+			state.specializations[i] = specializations[i]->getInfo();
+			state.stages[i].pSpecializationInfo = &state.specializations[i];
+		}
+
+		//Vertex input : attributes of the vertex format read by the vertex shader
+		state.binding = VertexFormat::getBindingDescription(description.vertexFormat);
+		state.attributes = ShaderReflection::getVertexAttributes(shaderLibrary->getInterface(description.vertexShader), description.vertexFormat);
+
+		state.vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		state.vertexInput.vertexBindingDescriptionCount = 1;
+		state.vertexInput.pVertexBindingDescriptions = &state.binding;
+		state.vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(state.attributes.size());
+		state.vertexInput.pVertexAttributeDescriptions = state.attributes.data();
+
+		//Input assembly : how vertices are linked
+		state.inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		state.inputAssembly.topology = description.topology;
+		state.inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		//Viewport state info (Viewport + scissor) : dynamic, set with the swapchain extent when recording
+		state.viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		state.viewportState.viewportCount = 1;
+		state.viewportState.pViewports = nullptr;
+		state.viewportState.scissorCount = 1;
+		state.viewportState.pScissors = nullptr;
+
+		//Rasterizer
+		state.rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		state.rasterizer.depthClampEnable = VK_FALSE;
+		state.rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		state.rasterizer.polygonMode = description.polygonMode;
+		state.rasterizer.lineWidth = 1.0f;
+		state.rasterizer.cullMode = description.cullMode;
+		state.rasterizer.frontFace = description.frontFace;
+		state.rasterizer.depthBiasEnable = VK_FALSE;
+		state.rasterizer.depthBiasConstantFactor = 0.0f;
+		state.rasterizer.depthBiasClamp = 0.0f;
+		state.rasterizer.depthBiasSlopeFactor = 0.0f;
+
+		//Multisampling
+		state.multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		state.multisampling.sampleShadingEnable = VK_FALSE;
+		state.multisampling.rasterizationSamples = description.samples;
+		state.multisampling.minSampleShading = 1.0f;
+		state.multisampling.pSampleMask = nullptr;
+		state.multisampling.alphaToCoverageEnable = VK_FALSE;
+		state.multisampling.alphaToOneEnable = VK_FALSE;
+
+		//Color blend Attachment : replace, or alpha blending
+		state.colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		state.colorBlendAttachment.blendEnable = description.blendEnable;
+		state.colorBlendAttachment.srcColorBlendFactor = description.blendEnable ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+		state.colorBlendAttachment.dstColorBlendFactor = description.blendEnable ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+		state.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		state.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		state.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		state.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		//Color blending
+		state.colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		state.colorBlending.logicOpEnable = VK_FALSE;
+		state.colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		state.colorBlending.attachmentCount = 1;
+		state.colorBlending.pAttachments = &state.colorBlendAttachment;
+		state.colorBlending.blendConstants[0] = 0.0f;
+		state.colorBlending.blendConstants[1] = 0.0f;
+		state.colorBlending.blendConstants[2] = 0.0f;
+		state.colorBlending.blendConstants[3] = 0.0f;
+
+		//Dynamic states : the pipeline doesn't depend on the window size
+		state.dynamicStates[0] = VK_DYNAMIC_STATE_VIEWPORT;
+		state.dynamicStates[1] = VK_DYNAMIC_STATE_SCISSOR;
+		state.dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		state.dynamicState.dynamicStateCount = 2;
+		state.dynamicState.pDynamicStates = state.dynamicStates;
+	}
+
+	/// <summary>
+	/// Hash of every field
+	/// </summary>
+	/// <returns></returns>
+	uint64_t PipelineDescription::getHash() const
+	{
+		uint64_t hash = Utils::HASH_SEED;
+		hash = Utils::hashValue(hash, vertexShader);
+		hash = Utils::hashValue(hash, fragmentShader);
+		hash = Utils::hashValue(hash, (uint64_t)vertexFormat);
+		hash = Utils::hashValue(hash, (uint64_t)topology);
+		hash = Utils::hashValue(hash, (uint64_t)polygonMode);
+		hash = Utils::hashValue(hash, (uint64_t)cullMode);
+		hash = Utils::hashValue(hash, (uint64_t)frontFace);
+		hash = Utils::hashValue(hash, (uint64_t)samples);
+		hash = Utils::hashValue(hash, (uint64_t)blendEnable);
+		hash = Utils::hashValue(hash, (uint64_t)layout);
+		hash = Utils::hashValue(hash, (uint64_t)renderPass);
+		hash = Utils::hashValue(hash, (uint64_t)subpass);
+		hash = Utils::hashValue(hash, (uint64_t)pushConstantStages);
+		hash = Utils::hashValue(hash, (uint64_t)pushConstantSize);
+		hash = Utils::hashValue(hash, vertexSpecialization.getHash());
+		hash = Utils::hashValue(hash, fragmentSpecialization.getHash());
+		return hash;
+	}
+
+	/// <summary>
+	/// Compare every field
+	/// </summary>
+	/// <param name="other"></param>
+	/// <returns></returns>
+	bool PipelineDescription::operator==(const PipelineDescription& other) const
+	{
+		return vertexShader == other.vertexShader && fragmentShader == other.fragmentShader
+			&& vertexFormat == other.vertexFormat && topology == other.topology
+			&& polygonMode == other.polygonMode && cullMode == other.cullMode
+			&& frontFace == other.frontFace && samples == other.samples
+			&& blendEnable == other.blendEnable && layout == other.layout
+			&& renderPass == other.renderPass && subpass == other.subpass
+			&& pushConstantStages == other.pushConstantStages && pushConstantSize == other.pushConstantSize
+			&& vertexSpecialization == other.vertexSpecialization && fragmentSpecialization == other.fragmentSpecialization;
+	}
+
+	/// <summary>
+	/// Pipeline Manager constructor : start compilation threads, monolithic path
+	/// </summary>
+	/// <param name="device"></param>
+	/// <param name="pipelineCache">Cache shared by all compilations</param>
+	/// <param name="shaderLibrary">Modules of the descriptions</param>
+	/// <param name="layoutCache">Layouts of the descriptions, for shader objects</param>
+	/// <param name="deletionQueue">Released pipelines wait for the frames using them</param>
+	/// <param name="threadCount">Compilation threads, 0 for half of the cores</param>
+	PipelineManager::PipelineManager(VkDevice device, PipelineCache* pipelineCache, ShaderLibrary* shaderLibrary, PipelineLayoutCache* layoutCache, DeletionQueue* deletionQueue, uint32_t threadCount)
+	{
+		m_device = device;
+		m_pipelineCache = pipelineCache;
+		m_shaderLibrary = shaderLibrary;
+		m_layoutCache = layoutCache;
+		m_deletionQueue = deletionQueue;
+		m_path = PIPELINE_PATH_MONOLITHIC;
+		m_pipelineLibraryEnabled = false;
+		m_shaderObjectEnabled = false;
+		m_nextHandle = 1;
+		m_libraryGeneration = 0;
+		m_pendingCount = 0;
+		m_stop = false;
+		m_requestCount = 0;
+
+		//The other cores record frames
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_threads.emplace_back(&PipelineManager::workerLoop, this);
+	}
+
+	/// <summary>
+	/// Pipeline Manager destructor : running compilations end, queued ones are dropped, GPU must be idle
+	/// </summary>
+	PipelineManager::~PipelineManager()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+			m_jobs.clear();
+		}
+		m_jobCondition.notify_all();
+
+		for (std::thread& thread : m_threads)
+			thread.join();
+
+		for (auto& entry : m_pipelines) {
+			if (entry.second.pipeline != VK_NULL_HANDLE)
+				vkDestroyPipeline(m_device, entry.second.pipeline, nullptr);
+
+			//Never compiled : shaders still retained
+			if (entry.second.state == PIPELINE_STATE_PENDING) {
+				m_shaderLibrary->release(entry.second.description.vertexShader);
+				m_shaderLibrary->release(entry.second.description.fragmentShader);
+			}
+		}
+
+		for (auto& library : m_libraries)
+			vkDestroyPipeline(m_device, library.second, nullptr);
+		for (auto& shader : m_shaderObjects)
+			m_shaderObject.destroyShader(m_device, shader.second, nullptr);
+
+		//Workers are stopped : nothing compiles against them anymore
+		for (VkRenderPass renderPass : m_retiredRenderPasses)
+			vkDestroyRenderPass(m_device, renderPass, nullptr);
+	}
+
+	/// <summary>
+	/// Enable the graphics pipeline library path, VK_EXT_graphics_pipeline_library must be enabled on the device
+	/// </summary>
+	void PipelineManager::enablePipelineLibrary()
+	{
+		m_pipelineLibraryEnabled = true;
+	}
+
+	/// <summary>
+	/// Enable the shader object path and load its commands, VK_EXT_shader_object must be enabled on the device
+	/// </summary>
+	void PipelineManager::enableShaderObjects()
+	{
+		loadDeviceFunction(m_device, "vkCreateShadersEXT", m_shaderObject.createShaders);
+		loadDeviceFunction(m_device, "vkDestroyShaderEXT", m_shaderObject.destroyShader);
+		loadDeviceFunction(m_device, "vkCmdBindShadersEXT", m_shaderObject.bindShaders);
+		loadDeviceFunction(m_device, "vkCmdSetViewportWithCountEXT", m_shaderObject.setViewportWithCount);
+		loadDeviceFunction(m_device, "vkCmdSetScissorWithCountEXT", m_shaderObject.setScissorWithCount);
+		loadDeviceFunction(m_device, "vkCmdSetVertexInputEXT", m_shaderObject.setVertexInput);
+		loadDeviceFunction(m_device, "vkCmdSetPrimitiveTopologyEXT", m_shaderObject.setPrimitiveTopology);
+		loadDeviceFunction(m_device, "vkCmdSetPrimitiveRestartEnableEXT", m_shaderObject.setPrimitiveRestartEnable);
+		loadDeviceFunction(m_device, "vkCmdSetRasterizerDiscardEnableEXT", m_shaderObject.setRasterizerDiscardEnable);
+		loadDeviceFunction(m_device, "vkCmdSetPolygonModeEXT", m_shaderObject.setPolygonMode);
+		loadDeviceFunction(m_device, "vkCmdSetCullModeEXT", m_shaderObject.setCullMode);
+		loadDeviceFunction(m_device, "vkCmdSetFrontFaceEXT", m_shaderObject.setFrontFace);
+		loadDeviceFunction(m_device, "vkCmdSetDepthBiasEnableEXT", m_shaderObject.setDepthBiasEnable);
+		loadDeviceFunction(m_device, "vkCmdSetDepthTestEnableEXT", m_shaderObject.setDepthTestEnable);
+		loadDeviceFunction(m_device, "vkCmdSetDepthWriteEnableEXT", m_shaderObject.setDepthWriteEnable);
+		loadDeviceFunction(m_device, "vkCmdSetDepthBoundsTestEnableEXT", m_shaderObject.setDepthBoundsTestEnable);
+		loadDeviceFunction(m_device, "vkCmdSetStencilTestEnableEXT", m_shaderObject.setStencilTestEnable);
+		loadDeviceFunction(m_device, "vkCmdSetRasterizationSamplesEXT", m_shaderObject.setRasterizationSamples);
+		loadDeviceFunction(m_device, "vkCmdSetSampleMaskEXT", m_shaderObject.setSampleMask);
+		loadDeviceFunction(m_device, "vkCmdSetAlphaToCoverageEnableEXT", m_shaderObject.setAlphaToCoverageEnable);
+		loadDeviceFunction(m_device, "vkCmdSetColorBlendEnableEXT", m_shaderObject.setColorBlendEnable);
+		loadDeviceFunction(m_device, "vkCmdSetColorBlendEquationEXT", m_shaderObject.setColorBlendEquation);
+		loadDeviceFunction(m_device, "vkCmdSetColorWriteMaskEXT", m_shaderObject.setColorWriteMask);
+		m_shaderObjectEnabled = true;
+	}
+
+	/// <summary>
+	/// Check if a path can be used
+	/// </summary>
+	/// <param name="path">PIPELINE_PATH_MONOLITHIC, PIPELINE_PATH_LIBRARY or PIPELINE_PATH_SHADER_OBJECT</param>
+	/// <returns></returns>
+	bool PipelineManager::isPathEnabled(int path) const
+	{
+		return path == PIPELINE_PATH_MONOLITHIC
+			|| (path == PIPELINE_PATH_LIBRARY && m_pipelineLibraryEnabled)
+			|| (path == PIPELINE_PATH_SHADER_OBJECT && m_shaderObjectEnabled);
+	}
+
+	/// <summary>
+	/// Set the path of the next requests, pipelines already requested keep theirs
+	/// </summary>
+	/// <param name="path"></param>
+	/// <returns>false if the path is not enabled, the path is unchanged</returns>
+	bool PipelineManager::setPath(int path)
+	{
+		if (!isPathEnabled(path))
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_path = path;
+		return true;
+	}
+
+	/// <summary>
+	/// Get path of the next requests
+	/// </summary>
+	/// <returns></returns>
+	int PipelineManager::getPath() const
+	{
+		return m_path;
+	}
+
+	/// <summary>
+	/// Get path a pipeline was requested on
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns></returns>
+	int PipelineManager::getPath(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_pipelines.find(handle);
+		if (found == m_pipelines.end())
+			throw std::runtime_error("Failed to get pipeline path, unknown handle");
+		return found->second.path;
+	}
+
+	/// <summary>
+	/// Request a pipeline on the current path, returns at once : a known description gives its pipeline, a new one is queued
+	/// </summary>
+	/// <param name="description">Shaders must be acquired, they are retained until compiled</param>
+	/// <returns>Handle to release</returns>
+	PipelineHandle PipelineManager::request(const PipelineDescription& description)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		uint64_t hash = Utils::hashValue(description.getHash(), (uint64_t)m_path);
+		m_requestCount++;
+
+		auto found = m_lookup.find(hash);
+		if (found != m_lookup.end()) {
+			PipelineEntry& entry = m_pipelines.at(found->second);
+			if (entry.description == description && entry.path == m_path) {
+				entry.refCount++;
+				return found->second;
+			}
+		}
+
+		PipelineHandle handle = m_nextHandle++;
+		PipelineEntry& entry = m_pipelines[handle];
+		entry.description = description;
+		entry.hash = hash;
+		entry.path = m_path;
+		entry.refCount = 1;
+		if (found == m_lookup.end())
+			m_lookup[hash] = handle;
+
+		m_shaderLibrary->retain(description.vertexShader);
+		m_shaderLibrary->retain(description.fragmentShader);
+
+		m_jobs.push_back(handle);
+		m_pendingCount++;
+		lock.unlock();
+		m_jobCondition.notify_one();
+		return handle;
+	}
+
+	/// <summary>
+	/// Release a reference, the pipeline is destroyed with the last one once the frames using it are done
+	/// </summary>
+	/// <param name="handle"></param>
+	void PipelineManager::release(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_pipelines.find(handle);
+		if (found == m_pipelines.end())
+			throw std::runtime_error("Failed to release pipeline, unknown handle");
+
+		//Still compiling : the worker destroys it when done
+		if (--found->second.refCount > 0 || found->second.state == PIPELINE_STATE_PENDING)
+			return;
+
+		destroyEntry(handle);
+	}
+
+	/// <summary>
+	/// Check if a pipeline can be bound
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns></returns>
+	bool PipelineManager::isReady(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_pipelines.find(handle);
+		return found != m_pipelines.end() && found->second.state == PIPELINE_STATE_READY;
+	}
+
+	/// <summary>
+	/// Get pipeline of a handle
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns>VK_NULL_HANDLE while compiling, if compilation failed, or for shader objects</returns>
+	VkPipeline PipelineManager::getPipeline(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_pipelines.find(handle);
+		if (found == m_pipelines.end() || found->second.state != PIPELINE_STATE_READY)
+			return VK_NULL_HANDLE;
+		return found->second.pipeline;
+	}
+
+	/// <summary>
+	/// Get state of a handle
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns>PIPELINE_STATE_PENDING, PIPELINE_STATE_READY or PIPELINE_STATE_FAILED</returns>
+	int PipelineManager::getState(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_pipelines.find(handle);
+		if (found == m_pipelines.end())
+			throw std::runtime_error("Failed to get pipeline state, unknown handle");
+		return found->second.state;
+	}
+
+	/// <summary>
+	/// Get description of a handle, for its layout and push constants when recording
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns></returns>
+	PipelineDescription PipelineManager::getDescription(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_pipelines.find(handle);
+		if (found == m_pipelines.end())
+			throw std::runtime_error("Failed to get pipeline description, unknown handle");
+		return found->second.description;
+	}
+
+	/// <summary>
+	/// Bind a pipeline with its viewport and scissor, shader objects also set the state of their description
+	/// </summary>
+	/// <param name="commandBuffer"></param>
+	/// <param name="handle"></param>
+	/// <param name="viewport"></param>
+	/// <param name="scissor"></param>
+	/// <returns>false if not ready, nothing is bound</returns>
+	bool PipelineManager::bind(VkCommandBuffer commandBuffer, PipelineHandle handle, const VkViewport& viewport, const VkRect2D& scissor)
+	{
+		PipelineEntry entry;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto found = m_pipelines.find(handle);
+			if (found == m_pipelines.end() || found->second.state != PIPELINE_STATE_READY)
+				return false;
+			entry = found->second;
+		}
+
+		if (entry.path == PIPELINE_PATH_SHADER_OBJECT) {
+			bindShaderObjects(commandBuffer, entry, viewport, scissor);
+			return true;
+		}
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, entry.pipeline);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		return true;
+	}
+
+	/// <summary>
+	/// Block until a pipeline is compiled
+	/// </summary>
+	/// <param name="handle"></param>
+	void PipelineManager::wait(PipelineHandle handle)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_doneCondition.wait(lock, [this, handle] {
+			auto found = m_pipelines.find(handle);
+			return found == m_pipelines.end() || found->second.state != PIPELINE_STATE_PENDING;
+		});
+	}
+
+	/// <summary>
+	/// Queue the destruction of the library parts, their layout or render pass is being destroyed
+	/// Parts still compiling belong to the previous generation, they are destroyed instead of being added
+	/// Shader objects only depend on the shader code and are kept
+	/// </summary>
+	void PipelineManager::clearLibraries()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& library : m_libraries)
+			m_deletionQueue->pushPipeline(library.second);
+		m_libraries.clear();
+		m_libraryGeneration++;
+	}
+
+	/// <summary>
+	/// Give a render pass to destroy : queued for destruction now, or once the last pipeline compiling against it is done
+	/// Released pipelines may still be compiling, the driver reads their render pass until vkCreateGraphicsPipelines returns
+	/// </summary>
+	/// <param name="renderPass">Not used by new requests anymore</param>
+	void PipelineManager::releaseRenderPass(VkRenderPass renderPass)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_retiredRenderPasses.push_back(renderPass);
+		collectRenderPasses();
+	}
+
+	/// <summary>
+	/// Get number of pipelines queued or compiling
+	/// </summary>
+	/// <returns></returns>
+	size_t PipelineManager::getPendingCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_pendingCount;
+	}
+
+	/// <summary>
+	/// Get creation cost of a path, from request to ready on a compilation thread
+	/// </summary>
+	/// <param name="path"></param>
+	/// <returns></returns>
+	PipelinePathStats PipelineManager::getPathStats(int path)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_pathStats.at(path);
+	}
+
+	/// <summary>
+	/// Print requests and creation cost per path
+	/// </summary>
+	void PipelineManager::printStats()
+	{
+		static const char* pathNames[PIPELINE_PATH_COUNT] = { "monolithic", "library", "shader object" };
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::cout << "Loukoum : pipelines, " << m_requestCount << " requests, " << m_pipelines.size() << " alive, "
+			<< m_libraries.size() << " library parts" << std::endl;
+		for (int path = 0; path < PIPELINE_PATH_COUNT; path++) {
+			const PipelinePathStats& stats = m_pathStats[path];
+			if (stats.count == 0)
+				continue;
+			std::cout << "Loukoum : " << pathNames[path] << " path, " << stats.count << " created, "
+				<< stats.totalTime / stats.count << " ms average, " << stats.maxTime << " ms max" << std::endl;
+		}
+	}
+
+	/// <summary>
+	/// Create a monolithic graphics pipeline, called from the compilation threads
+	/// </summary>
+	/// <param name="description"></param>
+	/// <returns>VK_NULL_HANDLE on failure</returns>
+	VkPipeline PipelineManager::createPipeline(const PipelineDescription& description)
+	{
+		PipelineState state;
+		fillPipelineState(description, m_shaderLibrary, state);
+
+		//Create Pipeline
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = state.stages;
+		pipelineInfo.pVertexInputState = &state.vertexInput;
+		pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+		pipelineInfo.pViewportState = &state.viewportState;
+		pipelineInfo.pRasterizationState = &state.rasterizer;
+		pipelineInfo.pMultisampleState = &state.multisampling;
+		pipelineInfo.pDepthStencilState = nullptr;
+		pipelineInfo.pColorBlendState = &state.colorBlending;
+		pipelineInfo.pDynamicState = &state.dynamicState;
+
+		//Link pipeline layout and render pass
+		pipelineInfo.layout = description.layout;
+		pipelineInfo.renderPass = description.renderPass;
+		pipelineInfo.subpass = description.subpass;
+
+		//No second pipeline
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		//The pipeline cache is internally synchronized, all threads share it
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		if (vkCreateGraphicsPipelines(m_device, m_pipelineCache->getCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+			return VK_NULL_HANDLE;
+		return pipeline;
+	}
+
+	/// <summary>
+	/// Link a pipeline from its 4 library parts, parts are created the first time their state is seen
+	/// Fast link without link time optimization : the parts are not recompiled
+	/// </summary>
+	/// <param name="description"></param>
+	/// <returns>VK_NULL_HANDLE on failure</returns>
+	VkPipeline PipelineManager::createLibraryPipeline(const PipelineDescription& description)
+	{
+		VkPipeline libraries[] = {
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, description),
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, description),
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, description),
+			getLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, description)
+		};
+		for (VkPipeline library : libraries) {
+			if (library == VK_NULL_HANDLE)
+				return VK_NULL_HANDLE;
+		}
+
+		VkPipelineLibraryCreateInfoKHR linkInfo{};
+		linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+		linkInfo.libraryCount = 4;
+		linkInfo.pLibraries = libraries;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = &linkInfo;
+		pipelineInfo.layout = description.layout;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		if (vkCreateGraphicsPipelines(m_device, m_pipelineCache->getCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+			return VK_NULL_HANDLE;
+		return pipeline;
+	}
+
+	/// <summary>
+	/// Get a library part, created if no pipeline used the same state before
+	/// Each part is keyed by the state it is made of only
+	/// </summary>
+	/// <param name="part">One VkGraphicsPipelineLibraryFlagBitsEXT</param>
+	/// <param name="description"></param>
+	/// <returns>VK_NULL_HANDLE on failure</returns>
+	VkPipeline PipelineManager::getLibrary(VkGraphicsPipelineLibraryFlagsEXT part, const PipelineDescription& description)
+	{
+		uint64_t key = Utils::hashValue(Utils::HASH_SEED, part);
+		switch (part) {
+		case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+			key = Utils::hashValue(key, (uint64_t)description.vertexFormat);
+			key = Utils::hashValue(key, (uint64_t)description.topology);
+			for (const ShaderInput& input : m_shaderLibrary->getInterface(description.vertexShader).inputs)
+				key = Utils::hashValue(key, input.location);
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+			key = Utils::hashValue(key, description.vertexShader);
+			key = Utils::hashValue(key, description.vertexSpecialization.getHash());
+			key = Utils::hashValue(key, (uint64_t)description.polygonMode);
+			key = Utils::hashValue(key, (uint64_t)description.cullMode);
+			key = Utils::hashValue(key, (uint64_t)description.frontFace);
+			key = Utils::hashValue(key, (uint64_t)description.layout);
+			key = Utils::hashValue(key, (uint64_t)description.renderPass);
+			key = Utils::hashValue(key, (uint64_t)description.subpass);
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+			key = Utils::hashValue(key, description.fragmentShader);
+			key = Utils::hashValue(key, description.fragmentSpecialization.getHash());
+			key = Utils::hashValue(key, (uint64_t)description.samples);
+			key = Utils::hashValue(key, (uint64_t)description.layout);
+			key = Utils::hashValue(key, (uint64_t)description.renderPass);
+			key = Utils::hashValue(key, (uint64_t)description.subpass);
+			break;
+		default:
+			key = Utils::hashValue(key, (uint64_t)description.blendEnable);
+			key = Utils::hashValue(key, (uint64_t)description.samples);
+			key = Utils::hashValue(key, (uint64_t)description.renderPass);
+			key = Utils::hashValue(key, (uint64_t)description.subpass);
+			break;
+		}
+
+		//Handles of destroyed layouts and render passes can be reused : the generation tells the parts apart
+		uint64_t generation;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			generation = m_libraryGeneration;
+			key = Utils::hashValue(key, generation);
+			auto found = m_libraries.find(key);
+			if (found != m_libraries.end())
+				return found->second;
+		}
+
+		PipelineState state;
+		fillPipelineState(description, m_shaderLibrary, state);
+
+		VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+		libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+		libraryInfo.flags = part;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = &libraryInfo;
+		pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		//Only the state of the part
+		switch (part) {
+		case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+			pipelineInfo.pVertexInputState = &state.vertexInput;
+			pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+			pipelineInfo.stageCount = 1;
+			pipelineInfo.pStages = &state.stages[0];
+			pipelineInfo.pViewportState = &state.viewportState;
+			pipelineInfo.pRasterizationState = &state.rasterizer;
+			pipelineInfo.pDynamicState = &state.dynamicState;
+			pipelineInfo.layout = description.layout;
+			pipelineInfo.renderPass = description.renderPass;
+			pipelineInfo.subpass = description.subpass;
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+			pipelineInfo.stageCount = 1;
+			pipelineInfo.pStages = &state.stages[1];
+			pipelineInfo.pMultisampleState = &state.multisampling;
+			pipelineInfo.layout = description.layout;
+			pipelineInfo.renderPass = description.renderPass;
+			pipelineInfo.subpass = description.subpass;
+			break;
+		default:
+			pipelineInfo.pMultisampleState = &state.multisampling;
+			pipelineInfo.pColorBlendState = &state.colorBlending;
+			pipelineInfo.renderPass = description.renderPass;
+			pipelineInfo.subpass = description.subpass;
+			break;
+		}
+
+		VkPipeline library = VK_NULL_HANDLE;
+		if (vkCreateGraphicsPipelines(m_device, m_pipelineCache->getCache(), 1, &pipelineInfo, nullptr, &library) != VK_SUCCESS)
+			return VK_NULL_HANDLE;
+
+		//Cleared meanwhile : made for a destroyed layout or render pass, never linked
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (generation != m_libraryGeneration) {
+			vkDestroyPipeline(m_device, library, nullptr);
+			return VK_NULL_HANDLE;
+		}
+
+		//Another thread may have created the same part meanwhile
+		auto inserted = m_libraries.emplace(key, library);
+		if (!inserted.second)
+			vkDestroyPipeline(m_device, library, nullptr);
+		return inserted.first->second;
+	}
+
+	/// <summary>
+	/// Get the vertex and fragment shader objects of a description
+	/// </summary>
+	/// <param name="description"></param>
+	/// <param name="shaders">Vertex then fragment</param>
+	/// <returns>false on failure</returns>
+	bool PipelineManager::createShaderObjects(const PipelineDescription& description, std::array<VkShaderEXT, 2>& shaders)
+	{
+		shaders[0] = getShaderObject(description.vertexShader, VK_SHADER_STAGE_VERTEX_BIT, description);
+		shaders[1] = getShaderObject(description.fragmentShader, VK_SHADER_STAGE_FRAGMENT_BIT, description);
+		return shaders[0] != VK_NULL_HANDLE && shaders[1] != VK_NULL_HANDLE;
+	}
+
+	/// <summary>
+	/// Get an unlinked shader object, created the first time a shader is used with this layout and specialization
+	/// </summary>
+	/// <param name="shader"></param>
+	/// <param name="stage">Vertex or fragment</param>
+	/// <param name="description">Layout and specialization constants</param>
+	/// <returns>VK_NULL_HANDLE on failure</returns>
+	VkShaderEXT PipelineManager::getShaderObject(ShaderHandle shader, VkShaderStageFlagBits stage, const PipelineDescription& description)
+	{
+		const ShaderSpecialization& specialization = stage == VK_SHADER_STAGE_VERTEX_BIT ? description.vertexSpecialization : description.fragmentSpecialization;
+		uint64_t key = Utils::hashValue(shader, (uint64_t)stage);
+		key = Utils::hashValue(key, (uint64_t)description.layout);
+		key = Utils::hashValue(key, specialization.getHash());
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto found = m_shaderObjects.find(key);
+			if (found != m_shaderObjects.end())
+				return found->second;
+		}
+
+		std::vector<char> code = m_shaderLibrary->getCode(shader);
+		std::vector<VkDescriptorSetLayout> setLayouts = m_layoutCache->getLayoutInfo(description.layout).setLayouts;
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = description.pushConstantStages;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = description.pushConstantSize;
+
+		specialization.check(m_shaderLibrary->getInterface(shader));
+		VkSpecializationInfo specializationInfo = specialization.getInfo();
+
+		VkShaderCreateInfoEXT shaderInfo{};
+		shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT;
+		shaderInfo.stage = stage;
+		shaderInfo.nextStage = stage == VK_SHADER_STAGE_VERTEX_BIT ? VK_SHADER_STAGE_FRAGMENT_BIT : 0;
+		shaderInfo.codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT;
+		shaderInfo.codeSize = code.size();
+		shaderInfo.pCode = code.data();
+		shaderInfo.pName = "main";
+		shaderInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		shaderInfo.pSetLayouts = setLayouts.data();
+		shaderInfo.pushConstantRangeCount = description.pushConstantSize > 0 ? 1 : 0;
+		shaderInfo.pPushConstantRanges = &pushConstantRange;
+		shaderInfo.pSpecializationInfo = specialization.isEmpty() ? nullptr : &specializationInfo;
+
+		VkShaderEXT shaderObject = VK_NULL_HANDLE;
+		if (m_shaderObject.createShaders(m_device, 1, &shaderInfo, nullptr, &shaderObject) != VK_SUCCESS)
+			return VK_NULL_HANDLE;
+
+		//Another thread may have created the same shader meanwhile
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto inserted = m_shaderObjects.emplace(key, shaderObject);
+		if (!inserted.second)
+			m_shaderObject.destroyShader(m_device, shaderObject, nullptr);
+		return inserted.first->second;
+	}
+
+	/// <summary>
+	/// Bind shader objects and set every state a pipeline would hold, all of it is dynamic with shader objects
+	/// </summary>
+	/// <param name="commandBuffer"></param>
+	/// <param name="entry"></param>
+	/// <param name="viewport"></param>
+	/// <param name="scissor"></param>
+	void PipelineManager::bindShaderObjects(VkCommandBuffer commandBuffer, const PipelineEntry& entry, const VkViewport& viewport, const VkRect2D& scissor)
+	{
+		const PipelineDescription& description = entry.description;
+		VkShaderStageFlagBits stages[] = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT };
+		m_shaderObject.bindShaders(commandBuffer, 2, stages, entry.shaders.data());
+
+		//Vertex input : attributes reflected when the shader objects were created
+		VkVertexInputBindingDescription binding = VertexFormat::getBindingDescription(description.vertexFormat);
+		VkVertexInputBindingDescription2EXT binding2{};
+		binding2.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
+		binding2.binding = binding.binding;
+		binding2.stride = binding.stride;
+		binding2.inputRate = binding.inputRate;
+		binding2.divisor = 1;
+
+		std::vector<VkVertexInputAttributeDescription2EXT> attributes2;
+		for (const VkVertexInputAttributeDescription& attribute : entry.vertexAttributes) {
+			VkVertexInputAttributeDescription2EXT attribute2{};
+			attribute2.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT;
+			attribute2.location = attribute.location;
+			attribute2.binding = attribute.binding;
+			attribute2.format = attribute.format;
+			attribute2.offset = attribute.offset;
+			attributes2.push_back(attribute2);
+		}
+		m_shaderObject.setVertexInput(commandBuffer, 1, &binding2, static_cast<uint32_t>(attributes2.size()), attributes2.data());
+		m_shaderObject.setPrimitiveTopology(commandBuffer, description.topology);
+		m_shaderObject.setPrimitiveRestartEnable(commandBuffer, VK_FALSE);
+
+		//Viewport and rasterizer
+		m_shaderObject.setViewportWithCount(commandBuffer, 1, &viewport);
+		m_shaderObject.setScissorWithCount(commandBuffer, 1, &scissor);
+		m_shaderObject.setRasterizerDiscardEnable(commandBuffer, VK_FALSE);
+		m_shaderObject.setPolygonMode(commandBuffer, description.polygonMode);
+		m_shaderObject.setCullMode(commandBuffer, description.cullMode);
+		m_shaderObject.setFrontFace(commandBuffer, description.frontFace);
+		m_shaderObject.setDepthBiasEnable(commandBuffer, VK_FALSE);
+		vkCmdSetLineWidth(commandBuffer, 1.0f);
+
+		//No depth stencil attachment
+		m_shaderObject.setDepthTestEnable(commandBuffer, VK_FALSE);
+		m_shaderObject.setDepthWriteEnable(commandBuffer, VK_FALSE);
+		m_shaderObject.setDepthBoundsTestEnable(commandBuffer, VK_FALSE);
+		m_shaderObject.setStencilTestEnable(commandBuffer, VK_FALSE);
+
+		//Multisampling
+		uint32_t sampleMask = 0xFFFFFFFF;
+		m_shaderObject.setRasterizationSamples(commandBuffer, description.samples);
+		m_shaderObject.setSampleMask(commandBuffer, description.samples, &sampleMask);
+		m_shaderObject.setAlphaToCoverageEnable(commandBuffer, VK_FALSE);
+
+		//Color blending : replace, or alpha blending
+		VkColorComponentFlags writeMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		m_shaderObject.setColorBlendEnable(commandBuffer, 0, 1, &description.blendEnable);
+		m_shaderObject.setColorWriteMask(commandBuffer, 0, 1, &writeMask);
+		if (description.blendEnable) {
+			VkColorBlendEquationEXT equation{};
+			equation.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+			equation.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			equation.colorBlendOp = VK_BLEND_OP_ADD;
+			equation.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			equation.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+			equation.alphaBlendOp = VK_BLEND_OP_ADD;
+			m_shaderObject.setColorBlendEquation(commandBuffer, 0, 1, &equation);
+		}
+	}
+
+	/// <summary>
+	/// Forget a pipeline and queue its destruction, lock must be held
+	/// </summary>
+	/// <param name="handle"></param>
+	void PipelineManager::destroyEntry(PipelineHandle handle)
+	{
+		auto found = m_pipelines.find(handle);
+		if (found->second.pipeline != VK_NULL_HANDLE)
+			m_deletionQueue->pushPipeline(found->second.pipeline);
+
+		auto lookup = m_lookup.find(found->second.hash);
+		if (lookup != m_lookup.end() && lookup->second == handle)
+			m_lookup.erase(lookup);
+		m_pipelines.erase(found);
+	}
+
+	/// <summary>
+	/// Check if a queued or compiling pipeline uses a render pass, lock must be held
+	/// </summary>
+	/// <param name="renderPass"></param>
+	/// <returns></returns>
+	bool PipelineManager::isRenderPassPending(VkRenderPass renderPass) const
+	{
+		for (const auto& entry : m_pipelines) {
+			if (entry.second.state == PIPELINE_STATE_PENDING && entry.second.description.renderPass == renderPass)
+				return true;
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Queue the destruction of released render passes no pipeline compiles against anymore, lock must be held
+	/// </summary>
+	void PipelineManager::collectRenderPasses()
+	{
+		auto renderPass = m_retiredRenderPasses.begin();
+		while (renderPass != m_retiredRenderPasses.end()) {
+			if (isRenderPassPending(*renderPass)) {
+				renderPass++;
+				continue;
+			}
+			m_deletionQueue->pushRenderPass(*renderPass);
+			renderPass = m_retiredRenderPasses.erase(renderPass);
+		}
+	}
+
+	/// <summary>
+	/// Compilation thread : compile queued pipelines on their path until stopped
+	/// </summary>
+	void PipelineManager::workerLoop()
+	{
+		while (true) {
+			PipelineHandle handle;
+			PipelineDescription description;
+			int path;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobCondition.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+				if (m_stop)
+					return;
+				handle = m_jobs.front();
+				m_jobs.pop_front();
+				description = m_pipelines.at(handle).description;
+				path = m_pipelines.at(handle).path;
+			}
+
+			//Released before its compilation : skipped
+			bool skipped;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				skipped = m_pipelines.at(handle).refCount == 0;
+			}
+
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			bool created = false;
+			std::array<VkShaderEXT, 2> shaders = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+			std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+			auto start = std::chrono::steady_clock::now();
+			try {
+				if (!skipped) {
+					switch (path) {
+					case PIPELINE_PATH_LIBRARY:
+						pipeline = createLibraryPipeline(description);
+						created = pipeline != VK_NULL_HANDLE;
+						break;
+					case PIPELINE_PATH_SHADER_OBJECT:
+						vertexAttributes = ShaderReflection::getVertexAttributes(m_shaderLibrary->getInterface(description.vertexShader), description.vertexFormat);
+						created = createShaderObjects(description, shaders);
+						break;
+					default:
+						pipeline = createPipeline(description);
+						created = pipeline != VK_NULL_HANDLE;
+						break;
+					}
+				}
+			}
+			catch (const std::exception& error) {
+				//Shaders not matching the vertex format : failed like a driver error
+				std::cout << "Loukoum : " << error.what() << std::endl;
+			}
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				PipelineEntry& entry = m_pipelines.at(handle);
+
+				//Requested again after being skipped : queued again, shaders stay retained
+				if (skipped && entry.refCount > 0) {
+					m_jobs.push_back(handle);
+					lock.unlock();
+					m_jobCondition.notify_one();
+					continue;
+				}
+
+				m_shaderLibrary->release(description.vertexShader);
+				m_shaderLibrary->release(description.fragmentShader);
+
+				entry.pipeline = pipeline;
+				entry.shaders = shaders;
+				entry.vertexAttributes = vertexAttributes;
+				entry.state = created ? PIPELINE_STATE_READY : PIPELINE_STATE_FAILED;
+				m_pendingCount--;
+
+				if (created) {
+					PipelinePathStats& stats = m_pathStats[path];
+					stats.count++;
+					stats.totalTime += milliseconds;
+					stats.maxTime = std::max(stats.maxTime, milliseconds);
+				}
+				else if (!skipped) {
+					std::cout << "Loukoum : failed to create graphics pipeline " << handle << std::endl;
+				}
+
+				if (entry.refCount == 0)
+					destroyEntry(handle);
+				if (!m_retiredRenderPasses.empty())
+					collectRenderPasses();
+			}
+			m_doneCondition.notify_all();
+		}
+	}
+}
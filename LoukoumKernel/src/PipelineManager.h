@@ -0,0 +1,229 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <deque>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include "VertexFormat.h"
+#include "ShaderLibrary.h"
+#include "ShaderReflection.h"
+#include "ShaderSpecialization.h"
+#include "PipelineLayoutCache.h"
+#include "PipelineCache.h"
+#include "DeletionQueue.h"
+
+namespace Loukoum
+{
+	//Pipeline handle, 0 is no pipeline
+	using PipelineHandle = uint32_t;
+
+	//Pipeline states
+	constexpr int PIPELINE_STATE_PENDING = 0;	//Queued or compiling
+	constexpr int PIPELINE_STATE_READY = 1;
+	constexpr int PIPELINE_STATE_FAILED = 2;
+
+	//Pipeline creation paths, the extension paths need the device extension (declared since Vulkan SDK 1.3.250)
+	constexpr int PIPELINE_PATH_MONOLITHIC = 0;		//One pipeline with all the state
+	constexpr int PIPELINE_PATH_LIBRARY = 1;		//VK_EXT_graphics_pipeline_library : 4 parts compiled once, linked per pipeline
+	constexpr int PIPELINE_PATH_SHADER_OBJECT = 2;	//VK_EXT_shader_object : shaders compiled once, state set when binding
+	constexpr int PIPELINE_PATH_COUNT = 3;
+
+	/// <summary>
+	/// Everything a graphics pipeline is built from : shaders, fixed-function state, layout and render pass
+	/// Viewport and scissor are dynamic, vertex attributes are the ones of the vertex format read by the vertex shader
+	/// </summary>
+	struct PipelineDescription {
+		ShaderHandle vertexShader = 0;
+		ShaderHandle fragmentShader = 0;
+		int vertexFormat = VERTEX_FORMAT_FLOAT;
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+		VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+		VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+		VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+		VkBool32 blendEnable = VK_FALSE;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint32_t subpass = 0;
+
+		//Push constants of the layout from the pipeline layout cache, shader objects are created with them
+		VkShaderStageFlags pushConstantStages = 0;
+		uint32_t pushConstantSize = 0;
+
+		//Specialization constants of each stage : variants of one shader are pipelines, not shader files
+		ShaderSpecialization vertexSpecialization;
+		ShaderSpecialization fragmentSpecialization;
+
+		uint64_t getHash() const;
+		bool operator==(const PipelineDescription& other) const;
+	};
+
+	/// <summary>
+	/// Pipeline known by the manager, shared by every request of the same description and path
+	/// </summary>
+	struct PipelineEntry {
+		PipelineDescription description;
+		uint64_t hash = 0;
+		int path = PIPELINE_PATH_MONOLITHIC;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		int state = PIPELINE_STATE_PENDING;
+		uint32_t refCount = 0;
+
+		//Shader object path : vertex and fragment shaders, owned by the shader object cache
+		std::array<VkShaderEXT, 2> shaders = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+	};
+
+	/// <summary>
+	/// Creation cost of one path
+	/// </summary>
+	struct PipelinePathStats {
+		uint64_t count = 0;
+		double totalTime = 0.0;
+		double maxTime = 0.0;
+	};
+
+	/// <summary>
+	/// Shader object commands, loaded from the device
+	/// </summary>
+	struct ShaderObjectFunctions {
+		PFN_vkCreateShadersEXT createShaders = nullptr;
+		PFN_vkDestroyShaderEXT destroyShader = nullptr;
+		PFN_vkCmdBindShadersEXT bindShaders = nullptr;
+		PFN_vkCmdSetViewportWithCountEXT setViewportWithCount = nullptr;
+		PFN_vkCmdSetScissorWithCountEXT setScissorWithCount = nullptr;
+		PFN_vkCmdSetVertexInputEXT setVertexInput = nullptr;
+		PFN_vkCmdSetPrimitiveTopologyEXT setPrimitiveTopology = nullptr;
+		PFN_vkCmdSetPrimitiveRestartEnableEXT setPrimitiveRestartEnable = nullptr;
+		PFN_vkCmdSetRasterizerDiscardEnableEXT setRasterizerDiscardEnable = nullptr;
+		PFN_vkCmdSetPolygonModeEXT setPolygonMode = nullptr;
+		PFN_vkCmdSetCullModeEXT setCullMode = nullptr;
+		PFN_vkCmdSetFrontFaceEXT setFrontFace = nullptr;
+		PFN_vkCmdSetDepthBiasEnableEXT setDepthBiasEnable = nullptr;
+		PFN_vkCmdSetDepthTestEnableEXT setDepthTestEnable = nullptr;
+		PFN_vkCmdSetDepthWriteEnableEXT setDepthWriteEnable = nullptr;
+		PFN_vkCmdSetDepthBoundsTestEnableEXT setDepthBoundsTestEnable = nullptr;
+		PFN_vkCmdSetStencilTestEnableEXT setStencilTestEnable = nullptr;
+		PFN_vkCmdSetRasterizationSamplesEXT setRasterizationSamples = nullptr;
+		PFN_vkCmdSetSampleMaskEXT setSampleMask = nullptr;
+		PFN_vkCmdSetAlphaToCoverageEnableEXT setAlphaToCoverageEnable = nullptr;
+		PFN_vkCmdSetColorBlendEnableEXT setColorBlendEnable = nullptr;
+		PFN_vkCmdSetColorBlendEquationEXT setColorBlendEquation = nullptr;
+		PFN_vkCmdSetColorWriteMaskEXT setColorWriteMask = nullptr;
+	};
+
+	/// <summary>
+	/// Pipeline Manager : pipelines are requested by description and compiled on worker threads into the pipeline cache
+	/// Requests return at once, the pipeline is used once ready, identical descriptions share one pipeline
+	/// Extension paths reuse parts compiled for previous pipelines : library parts, or shader objects
+	/// </summary>
+	class PipelineManager
+	{
+	public:
+		PipelineManager(VkDevice device, PipelineCache* pipelineCache, ShaderLibrary* shaderLibrary, PipelineLayoutCache* layoutCache, DeletionQueue* deletionQueue, uint32_t threadCount = 0);
+		~PipelineManager();
+
+		PipelineManager(const PipelineManager&) = delete;
+		PipelineManager& operator=(const PipelineManager&) = delete;
+
+		//Extension paths, the device extensions must be enabled
+		void enablePipelineLibrary();
+		void enableShaderObjects();
+		bool isPathEnabled(int path) const;
+
+		//Path of the next requests, false if not enabled
+		bool setPath(int path);
+		int getPath() const;
+		int getPath(PipelineHandle handle);
+
+		//Add a reference, compilation is queued for new descriptions
+		PipelineHandle request(const PipelineDescription& description);
+		void release(PipelineHandle handle);
+
+		//Never blocks
+		bool isReady(PipelineHandle handle);
+		VkPipeline getPipeline(PipelineHandle handle);
+		int getState(PipelineHandle handle);
+		PipelineDescription getDescription(PipelineHandle handle);
+
+		//Bind a ready pipeline and set its dynamic state, from any recording thread
+		bool bind(VkCommandBuffer commandBuffer, PipelineHandle handle, const VkViewport& viewport, const VkRect2D& scissor);
+
+		//Block until compiled, for pipelines needed right away
+		void wait(PipelineHandle handle);
+
+		//Library parts are made for a layout and render pass : forget them when those are destroyed
+		void clearLibraries();
+
+		//Destroy a render pass once no queued or compiling pipeline uses it
+		void releaseRenderPass(VkRenderPass renderPass);
+
+		//Stats
+		size_t getPendingCount();
+		PipelinePathStats getPathStats(int path);
+		void printStats();
+
+	private:
+		VkPipeline createPipeline(const PipelineDescription& description);
+		VkPipeline createLibraryPipeline(const PipelineDescription& description);
+		VkPipeline getLibrary(VkGraphicsPipelineLibraryFlagsEXT part, const PipelineDescription& description);
+		bool createShaderObjects(const PipelineDescription& description, std::array<VkShaderEXT, 2>& shaders);
+		VkShaderEXT getShaderObject(ShaderHandle shader, VkShaderStageFlagBits stage, const PipelineDescription& description);
+		void bindShaderObjects(VkCommandBuffer commandBuffer, const PipelineEntry& entry, const VkViewport& viewport, const VkRect2D& scissor);
+		void destroyEntry(PipelineHandle handle);
+		bool isRenderPassPending(VkRenderPass renderPass) const;
+		void collectRenderPasses();
+		void workerLoop();
+
+		VkDevice m_device;
+		PipelineCache* m_pipelineCache;
+		ShaderLibrary* m_shaderLibrary;
+		PipelineLayoutCache* m_layoutCache;
+		DeletionQueue* m_deletionQueue;
+
+		//Paths
+		int m_path;
+		bool m_pipelineLibraryEnabled;
+		bool m_shaderObjectEnabled;
+
+		//Pipelines by handle, handles by description and path hash
+		std::unordered_map<PipelineHandle, PipelineEntry> m_pipelines;
+		std::unordered_map<uint64_t, PipelineHandle> m_lookup;
+		PipelineHandle m_nextHandle;
+
+		//Parts reused by the extension paths, by hash of the state they depend on
+		std::unordered_map<uint64_t, VkPipeline> m_libraries;
+
+		//Bumped by clearLibraries : part of the library keys, parts of an older generation are not kept
+		uint64_t m_libraryGeneration;
+		std::unordered_map<uint64_t, VkShaderEXT> m_shaderObjects;
+		ShaderObjectFunctions m_shaderObject;
+
+		//Render passes released while pipelines of them were still compiling
+		std::vector<VkRenderPass> m_retiredRenderPasses;
+
+		//Workers
+		std::vector<std::thread> m_threads;
+		std::deque<PipelineHandle> m_jobs;
+		size_t m_pendingCount;
+		bool m_stop;
+
+		//Stats
+		uint64_t m_requestCount;
+		std::array<PipelinePathStats, PIPELINE_PATH_COUNT> m_pathStats;
+
+		std::mutex m_mutex;
+		std::condition_variable m_jobCondition;
+		std::condition_variable m_doneCondition;
+	};
+}
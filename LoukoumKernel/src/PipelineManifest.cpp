@@ -0,0 +1,258 @@
+#include "PipelineManifest.h"
+
+namespace Loukoum
+{
+	//First line of a manifest file
+	static constexpr const char* MANIFEST_HEADER = "LoukoumPipelineManifest";
+
+	/// <summary>
+	/// Pipeline Manifest constructor : load the pipelines of the previous runs
+	/// </summary>
+	/// <param name="filename">Manifest file, created on save if missing</param>
+	PipelineManifest::PipelineManifest(const std::string& filename)
+	{
+		m_filename = filename;
+		m_changed = false;
+		load();
+	}
+
+	/// <summary>
+	/// Pipeline Manifest destructor : save
+	/// </summary>
+	PipelineManifest::~PipelineManifest()
+	{
+		save();
+	}
+
+	/// <summary>
+	/// Add a pipeline built during this run
+	/// </summary>
+	/// <param name="vertexSource"></param>
+	/// <param name="fragmentSource"></param>
+	/// <param name="description">Shaders, layout and render pass are not kept</param>
+	void PipelineManifest::record(const ShaderSource& vertexSource, const ShaderSource& fragmentSource, const PipelineDescription& description)
+	{
+		PipelineManifestEntry entry;
+		entry.vertexSource = vertexSource;
+		entry.fragmentSource = fragmentSource;
+		entry.description = description;
+		entry.description.vertexShader = 0;
+		entry.description.fragmentShader = 0;
+		entry.description.layout = VK_NULL_HANDLE;
+		entry.description.renderPass = VK_NULL_HANDLE;
+
+		if (!m_lines.insert(serialize(entry)).second)
+			return;
+
+		m_entries.push_back(entry);
+		m_changed = true;
+	}
+
+	/// <summary>
+	/// Get pipelines of the previous runs and of this one
+	/// </summary>
+	/// <returns></returns>
+	const std::vector<PipelineManifestEntry>& PipelineManifest::getEntries() const
+	{
+		return m_entries;
+	}
+
+	/// <summary>
+	/// Remove a pipeline, for a stale entry whose sources or state are not valid anymore
+	/// </summary>
+	/// <param name="entry">Entry as returned by getEntries</param>
+	void PipelineManifest::remove(const PipelineManifestEntry& entry)
+	{
+		std::string line = serialize(entry);
+		if (m_lines.erase(line) == 0)
+			return;
+
+		for (size_t i = 0; i < m_entries.size(); i++) {
+			if (serialize(m_entries[i]) == line) {
+				m_entries.erase(m_entries.begin() + i);
+				break;
+			}
+		}
+		m_changed = true;
+	}
+
+	/// <summary>
+	/// Write the manifest if pipelines were added, through a temporary file
+	/// </summary>
+	/// <returns>true if the file was written</returns>
+	bool PipelineManifest::save()
+	{
+		if (!m_changed)
+			return false;
+
+		std::string tempFilename = m_filename + ".tmp";
+		{
+			std::ofstream file(tempFilename, std::ios::trunc);
+			file << MANIFEST_HEADER << " " << VERSION << "\n";
+			for (const PipelineManifestEntry& entry : m_entries)
+				file << serialize(entry) << "\n";
+			if (!file.good()) {
+				std::cout << "Loukoum : failed to write pipeline manifest " << tempFilename << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempFilename, m_filename, error);
+		if (error) {
+			std::cout << "Loukoum : failed to replace pipeline manifest " << m_filename << " : " << error.message() << std::endl;
+			return false;
+		}
+
+		m_changed = false;
+		return true;
+	}
+
+	/// <summary>
+	/// Read the manifest file, lines that don't parse are dropped
+	/// </summary>
+	void PipelineManifest::load()
+	{
+		std::ifstream file(m_filename);
+		if (!file.is_open())
+			return;
+
+		std::string header;
+		uint32_t version = 0;
+		file >> header >> version;
+		if (header != MANIFEST_HEADER || version != VERSION) {
+			std::cout << "Loukoum : pipeline manifest " << m_filename << " ignored, other version" << std::endl;
+			return;
+		}
+
+		std::string line;
+		while (std::getline(file, line)) {
+			PipelineManifestEntry entry;
+			if (line.empty() || !parse(line, entry))
+				continue;
+			if (m_lines.insert(serialize(entry)).second)
+				m_entries.push_back(entry);
+		}
+
+		std::cout << "Loukoum : pipeline manifest loaded, " << m_entries.size() << " pipelines" << std::endl;
+	}
+
+	/// <summary>
+	/// Write an entry on one line
+	/// </summary>
+	/// <param name="entry"></param>
+	/// <returns></returns>
+	std::string PipelineManifest::serialize(const PipelineManifestEntry& entry)
+	{
+		const PipelineDescription& description = entry.description;
+		std::ostringstream stream;
+		stream << description.vertexFormat << " " << description.topology << " " << description.polygonMode << " "
+			<< description.cullMode << " " << description.frontFace << " " << description.samples << " "
+			<< description.blendEnable << " " << description.subpass << " " << description.pushConstantStages << " " << description.pushConstantSize;
+		serializeSource(stream, entry.vertexSource);
+		serializeSource(stream, entry.fragmentSource);
+		serializeSpecialization(stream, description.vertexSpecialization);
+		serializeSpecialization(stream, description.fragmentSpecialization);
+		return stream.str();
+	}
+
+	/// <summary>
+	/// Write a shader source : stage, file, define count, then name=value for each define
+	/// </summary>
+	/// <param name="stream"></param>
+	/// <param name="source"></param>
+	void PipelineManifest::serializeSource(std::ostream& stream, const ShaderSource& source)
+	{
+		stream << " " << source.stage << " " << source.filename << " " << source.defines.size();
+		for (const auto& define : source.defines)
+			stream << " " << define.first << "=" << define.second;
+	}
+
+	/// <summary>
+	/// Write specialization constants : constant count, then id=bits for each constant
+	/// </summary>
+	/// <param name="stream"></param>
+	/// <param name="specialization"></param>
+	void PipelineManifest::serializeSpecialization(std::ostream& stream, const ShaderSpecialization& specialization)
+	{
+		const std::vector<VkSpecializationMapEntry>& entries = specialization.getEntries();
+		stream << " " << entries.size();
+		for (size_t i = 0; i < entries.size(); i++)
+			stream << " " << entries[i].constantID << "=" << specialization.getValue(i);
+	}
+
+	/// <summary>
+	/// Read an entry written by serialize
+	/// </summary>
+	/// <param name="line"></param>
+	/// <param name="entry"></param>
+	/// <returns>false if the line is invalid</returns>
+	bool PipelineManifest::parse(const std::string& line, PipelineManifestEntry& entry)
+	{
+		std::istringstream stream(line);
+		PipelineDescription& description = entry.description;
+		uint32_t topology, polygonMode, cullMode, frontFace, samples;
+		stream >> description.vertexFormat >> topology >> polygonMode >> cullMode >> frontFace >> samples >> description.blendEnable >> description.subpass
+			>> description.pushConstantStages >> description.pushConstantSize;
+		if (!stream)
+			return false;
+
+		description.topology = (VkPrimitiveTopology)topology;
+		description.polygonMode = (VkPolygonMode)polygonMode;
+		description.cullMode = (VkCullModeFlags)cullMode;
+		description.frontFace = (VkFrontFace)frontFace;
+		description.samples = (VkSampleCountFlagBits)samples;
+		return parseSource(stream, entry.vertexSource) && parseSource(stream, entry.fragmentSource)
+			&& parseSpecialization(stream, description.vertexSpecialization) && parseSpecialization(stream, description.fragmentSpecialization);
+	}
+
+	/// <summary>
+	/// Read a shader source written by serializeSource
+	/// </summary>
+	/// <param name="stream"></param>
+	/// <param name="source"></param>
+	/// <returns>false if invalid</returns>
+	bool PipelineManifest::parseSource(std::istream& stream, ShaderSource& source)
+	{
+		uint32_t stage;
+		size_t defineCount;
+		stream >> stage >> source.filename >> defineCount;
+		if (!stream)
+			return false;
+		source.stage = (VkShaderStageFlagBits)stage;
+
+		for (size_t i = 0; i < defineCount; i++) {
+			std::string define;
+			stream >> define;
+			size_t separator = define.find('=');
+			if (!stream || separator == std::string::npos)
+				return false;
+			source.defines.emplace_back(define.substr(0, separator), define.substr(separator + 1));
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Read specialization constants written by serializeSpecialization
+	/// </summary>
+	/// <param name="stream"></param>
+	/// <param name="specialization"></param>
+	/// <returns>false if invalid</returns>
+	bool PipelineManifest::parseSpecialization(std::istream& stream, ShaderSpecialization& specialization)
+	{
+		size_t constantCount;
+		stream >> constantCount;
+		if (!stream)
+			return false;
+
+		for (size_t i = 0; i < constantCount; i++) {
+			uint32_t id, value;
+			char separator;
+			stream >> id >> separator >> value;
+			if (!stream || separator != '=')
+				return false;
+			specialization.set(id, value);
+		}
+		return true;
+	}
+}
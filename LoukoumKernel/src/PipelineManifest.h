@@ -0,0 +1,76 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+#include "ShaderCompiler.h"
+#include "PipelineManager.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Pipeline built during a run : shader sources, fixed-function state and specialization constants
+	/// Shaders, layout and render pass of the description are set when replayed
+	/// </summary>
+	struct PipelineManifestEntry {
+		ShaderSource vertexSource;
+		ShaderSource fragmentSource;
+		PipelineDescription description;
+	};
+
+	/// <summary>
+	/// Pipeline Manifest : every pipeline description built during a run, saved to replay them while loading the next one
+	/// Text file, one pipeline per line, file names and defines must not contain spaces
+	/// </summary>
+	class PipelineManifest
+	{
+	public:
+		PipelineManifest(const std::string& filename = DEFAULT_FILENAME);
+		~PipelineManifest();
+
+		PipelineManifest(const PipelineManifest&) = delete;
+		PipelineManifest& operator=(const PipelineManifest&) = delete;
+
+		//Add a pipeline, ignored if already known
+		void record(const ShaderSource& vertexSource, const ShaderSource& fragmentSource, const PipelineDescription& description);
+
+		//Pipelines loaded and recorded
+		const std::vector<PipelineManifestEntry>& getEntries() const;
+
+		//Drop a pipeline that can't be built anymore, saved without it
+		void remove(const PipelineManifestEntry& entry);
+
+		//Save to disk, only when pipelines were added
+		bool save();
+
+		//Manifest file in the working directory
+		static constexpr const char* DEFAULT_FILENAME = "pipelines.manifest";
+
+		//Files of another version are ignored
+		static constexpr uint32_t VERSION = 3;
+
+	private:
+		void load();
+		static std::string serialize(const PipelineManifestEntry& entry);
+		static void serializeSource(std::ostream& stream, const ShaderSource& source);
+		static bool parse(const std::string& line, PipelineManifestEntry& entry);
+		static bool parseSource(std::istream& stream, ShaderSource& source);
+		static void serializeSpecialization(std::ostream& stream, const ShaderSpecialization& specialization);
+		static bool parseSpecialization(std::istream& stream, ShaderSpecialization& specialization);
+
+		std::string m_filename;
+		std::vector<PipelineManifestEntry> m_entries;
+
+		//Serialized entries, for duplicates
+		std::set<std::string> m_lines;
+		bool m_changed;
+	};
+}
@@ -0,0 +1,307 @@
+#include "ShaderCompiler.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Shader Compiler constructor : start the compilation thread
+	/// </summary>
+	/// <param name="sourceDirectory">Directory of the GLSL files</param>
+	/// <param name="cacheDirectory">Directory of the compiled SPIR-V, created if missing</param>
+	ShaderCompiler::ShaderCompiler(const std::string& sourceDirectory, const std::string& cacheDirectory)
+	{
+		m_sourceDirectory = sourceDirectory;
+		m_cacheDirectory = cacheDirectory;
+		m_lastPoll = std::chrono::steady_clock::now();
+		m_stop = false;
+
+		std::error_code error;
+		std::filesystem::create_directories(m_cacheDirectory, error);
+		if (error)
+			std::cout << "Loukoum : failed to create shader cache " << m_cacheDirectory << " : " << error.message() << std::endl;
+
+		m_worker = std::thread(&ShaderCompiler::workerLoop, this);
+	}
+
+	/// <summary>
+	/// Shader Compiler destructor : the running compilation ends, queued ones are dropped
+	/// </summary>
+	ShaderCompiler::~ShaderCompiler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+			m_jobs.clear();
+		}
+		m_jobCondition.notify_all();
+		m_worker.join();
+	}
+
+	/// <summary>
+	/// Compile a shader on the calling thread, read from the cache when the source did not change
+	/// </summary>
+	/// <param name="source"></param>
+	/// <returns>SPIR-V code</returns>
+	std::vector<char> ShaderCompiler::compile(const ShaderSource& source)
+	{
+		CompiledShader shader = compileSource(source);
+		if (shader.code.empty()) {
+			std::cout << shader.error << std::endl;
+			throw std::runtime_error("Failed to compile shader " + source.filename);
+		}
+		return shader.code;
+	}
+
+	/// <summary>
+	/// Recompile a source each time its file changes, results come from takeCompiled
+	/// </summary>
+	/// <param name="source"></param>
+	void ShaderCompiler::watch(const ShaderSource& source)
+	{
+		for (WatchedShader& watched : m_watched) {
+			if (watched.source.filename == source.filename && watched.source.stage == source.stage) {
+				watched.source = source;
+				return;
+			}
+		}
+
+		WatchedShader watched;
+		watched.source = source;
+		watched.lastWrite = getWriteTime(source.filename);
+		m_watched.push_back(watched);
+	}
+
+	/// <summary>
+	/// Poll the watched files, changed ones are queued on the compilation thread, called once per frame
+	/// </summary>
+	void ShaderCompiler::update()
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<double>(now - m_lastPoll).count() < POLL_INTERVAL)
+			return;
+		m_lastPoll = now;
+
+		bool queued = false;
+		for (WatchedShader& watched : m_watched) {
+			std::filesystem::file_time_type lastWrite = getWriteTime(watched.source.filename);
+			if (lastWrite == watched.lastWrite || watched.pending)
+				continue;
+
+			watched.lastWrite = lastWrite;
+			watched.pending = true;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(watched.source);
+			queued = true;
+		}
+
+		if (queued)
+			m_jobCondition.notify_one();
+	}
+
+	/// <summary>
+	/// Get the compilations finished since the last call, failed ones have an error and no code
+	/// </summary>
+	/// <returns></returns>
+	std::vector<CompiledShader> ShaderCompiler::takeCompiled()
+	{
+		std::vector<CompiledShader> compiled;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			compiled.swap(m_compiled);
+		}
+
+		for (const CompiledShader& shader : compiled) {
+			for (WatchedShader& watched : m_watched) {
+				if (watched.source.filename == shader.source.filename && watched.source.stage == shader.source.stage)
+					watched.pending = false;
+			}
+		}
+		return compiled;
+	}
+
+	/// <summary>
+	/// Read the source, then take the SPIR-V from the cache or compile it
+	/// </summary>
+	/// <param name="source"></param>
+	/// <returns></returns>
+	CompiledShader ShaderCompiler::compileSource(const ShaderSource& source)
+	{
+		CompiledShader shader;
+		shader.source = source;
+
+		std::ifstream file(m_sourceDirectory + source.filename, std::ios::binary);
+		if (!file.is_open()) {
+			shader.error = "Loukoum : failed to open shader " + m_sourceDirectory + source.filename;
+			return shader;
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		std::string glsl = stream.str();
+
+		std::string cacheFilename = getCacheFilename(getCacheKey(source, glsl));
+		if (readCache(cacheFilename, shader.code)) {
+			shader.cached = true;
+			return shader;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		shader.code = compileGlsl(source, glsl, shader.error);
+		if (shader.code.empty())
+			return shader;
+
+		double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Loukoum : shader " << source.filename << " compiled in " << time << " ms" << std::endl;
+		writeCache(cacheFilename, shader.code);
+		return shader;
+	}
+
+	/// <summary>
+	/// Compile GLSL to SPIR-V
+	/// </summary>
+	/// <param name="source"></param>
+	/// <param name="glsl">Source text</param>
+	/// <param name="error">Compiler messages on failure</param>
+	/// <returns>SPIR-V code, empty on failure</returns>
+	std::vector<char> ShaderCompiler::compileGlsl(const ShaderSource& source, const std::string& glsl, std::string& error)
+	{
+		shaderc_shader_kind kind;
+		switch (source.stage) {
+		case VK_SHADER_STAGE_VERTEX_BIT: kind = shaderc_glsl_vertex_shader; break;
+		case VK_SHADER_STAGE_FRAGMENT_BIT: kind = shaderc_glsl_fragment_shader; break;
+		case VK_SHADER_STAGE_COMPUTE_BIT: kind = shaderc_glsl_compute_shader; break;
+		case VK_SHADER_STAGE_GEOMETRY_BIT: kind = shaderc_glsl_geometry_shader; break;
+		case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: kind = shaderc_glsl_tess_control_shader; break;
+		case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: kind = shaderc_glsl_tess_evaluation_shader; break;
+		default:
+			error = "Loukoum : unsupported shader stage for " + source.filename;
+			return {};
+		}
+
+		shaderc::CompileOptions options;
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		for (const auto& define : source.defines)
+			options.AddMacroDefinition(define.first, define.second);
+
+		//One compiler per compilation, the render thread and the worker may compile at once
+		shaderc::Compiler compiler;
+		shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(glsl.data(), glsl.size(), kind, source.filename.c_str(), options);
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+			error = "Loukoum : failed to compile shader " + source.filename + "\n" + result.GetErrorMessage();
+			return {};
+		}
+
+		std::vector<uint32_t> words(result.cbegin(), result.cend());
+		std::vector<char> code(words.size() * sizeof(uint32_t));
+		memcpy(code.data(), words.data(), code.size());
+		return code;
+	}
+
+	/// <summary>
+	/// Key of a compilation : hash of the source text, stage, defines and cache version
+	/// </summary>
+	/// <param name="source"></param>
+	/// <param name="glsl"></param>
+	/// <returns></returns>
+	uint64_t ShaderCompiler::getCacheKey(const ShaderSource& source, const std::string& glsl)
+	{
+		std::string key = glsl;
+		key += '\0' + std::to_string(source.stage) + '\0' + std::to_string(CACHE_VERSION);
+		for (const auto& define : source.defines)
+			key += '\0' + define.first + '=' + define.second;
+
+		return ShaderLibrary::hashCode(std::vector<char>(key.begin(), key.end()));
+	}
+
+	/// <summary>
+	/// Get cache file of a key
+	/// </summary>
+	/// <param name="key"></param>
+	/// <returns></returns>
+	std::string ShaderCompiler::getCacheFilename(uint64_t key)
+	{
+		std::stringstream filename;
+		filename << m_cacheDirectory << std::hex << std::setw(16) << std::setfill('0') << key << ".spv";
+		return filename.str();
+	}
+
+	/// <summary>
+	/// Read a cached SPIR-V file
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="code"></param>
+	/// <returns>false if missing or invalid</returns>
+	bool ShaderCompiler::readCache(const std::string& filename, std::vector<char>& code)
+	{
+		std::ifstream file(filename, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		code.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read(code.data(), code.size());
+		if (!file.good() || code.empty() || code.size() % 4 != 0) {
+			code.clear();
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Write a cached SPIR-V file through a temporary file, the worker and the render thread may write at once
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="code"></param>
+	void ShaderCompiler::writeCache(const std::string& filename, const std::vector<char>& code)
+	{
+		std::stringstream tempFilename;
+		tempFilename << filename << "." << std::this_thread::get_id() << ".tmp";
+		{
+			std::ofstream file(tempFilename.str(), std::ios::binary | std::ios::trunc);
+			file.write(code.data(), code.size());
+			if (!file.good()) {
+				std::cout << "Loukoum : failed to write shader cache " << tempFilename.str() << std::endl;
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempFilename.str(), filename, error);
+		if (error)
+			std::cout << "Loukoum : failed to replace shader cache " << filename << " : " << error.message() << std::endl;
+	}
+
+	/// <summary>
+	/// Get last write time of a source, the minimum when missing
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <returns></returns>
+	std::filesystem::file_time_type ShaderCompiler::getWriteTime(const std::string& filename)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type time = std::filesystem::last_write_time(m_sourceDirectory + filename, error);
+		return error ? std::filesystem::file_time_type::min() : time;
+	}
+
+	/// <summary>
+	/// Compilation thread : compile queued sources until stopped
+	/// </summary>
+	void ShaderCompiler::workerLoop()
+	{
+		while (true) {
+			ShaderSource source;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobCondition.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+				if (m_stop)
+					return;
+				source = m_jobs.front();
+				m_jobs.pop_front();
+			}
+
+			CompiledShader shader = compileSource(source);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_compiled.push_back(std::move(shader));
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <shaderc/shaderc.hpp>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "ShaderLibrary.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// GLSL source of a shader : file in the source directory, stage and preprocessor defines
+	/// </summary>
+	struct ShaderSource {
+		std::string filename;
+		VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+		std::vector<std::pair<std::string, std::string>> defines;
+	};
+
+	/// <summary>
+	/// Result of a compilation, the code is empty on failure
+	/// </summary>
+	struct CompiledShader {
+		ShaderSource source;
+		std::vector<char> code;
+		std::string error;
+		bool cached = false;
+	};
+
+	/// <summary>
+	/// Watched source, recompiled when its write time changes
+	/// </summary>
+	struct WatchedShader {
+		ShaderSource source;
+		std::filesystem::file_time_type lastWrite;
+		bool pending = false;
+	};
+
+	/// <summary>
+	/// Shader Compiler : GLSL to SPIR-V with shaderc, results kept on disk by source and define hash
+	/// Watched sources are polled, changed ones are compiled on a worker thread and picked up by the render thread
+	/// </summary>
+	class ShaderCompiler
+	{
+	public:
+		ShaderCompiler(const std::string& sourceDirectory = DEFAULT_SOURCE_DIRECTORY, const std::string& cacheDirectory = DEFAULT_CACHE_DIRECTORY);
+		~ShaderCompiler();
+
+		ShaderCompiler(const ShaderCompiler&) = delete;
+		ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+		//Blocking compilation through the disk cache, throws on error
+		std::vector<char> compile(const ShaderSource& source);
+
+		//Hot reload : poll watched files, compilations done since the last call
+		void watch(const ShaderSource& source);
+		void update();
+		std::vector<CompiledShader> takeCompiled();
+
+		//Sources next to the kernel project, cache in the working directory
+		static constexpr const char* DEFAULT_SOURCE_DIRECTORY = "../LoukoumKernel/";
+		static constexpr const char* DEFAULT_CACHE_DIRECTORY = "shader_cache/";
+
+		//Seconds between two polls of the watched files
+		static constexpr double POLL_INTERVAL = 0.5;
+
+		//Changes the key of every cached shader, increment when compile options change
+		static constexpr uint32_t CACHE_VERSION = 1;
+
+	private:
+		CompiledShader compileSource(const ShaderSource& source);
+		std::vector<char> compileGlsl(const ShaderSource& source, const std::string& glsl, std::string& error);
+		uint64_t getCacheKey(const ShaderSource& source, const std::string& glsl);
+		std::string getCacheFilename(uint64_t key);
+		bool readCache(const std::string& filename, std::vector<char>& code);
+		void writeCache(const std::string& filename, const std::vector<char>& code);
+		std::filesystem::file_time_type getWriteTime(const std::string& filename);
+		void workerLoop();
+
+		std::string m_sourceDirectory;
+		std::string m_cacheDirectory;
+
+		//Watched files, only used by the render thread
+		std::vector<WatchedShader> m_watched;
+		std::chrono::steady_clock::time_point m_lastPoll;
+
+		//Worker : sources to compile, results to take
+		std::thread m_worker;
+		std::deque<ShaderSource> m_jobs;
+		std::vector<CompiledShader> m_compiled;
+		bool m_stop;
+
+		std::mutex m_mutex;
+		std::condition_variable m_jobCondition;
+	};
+}
@@ -0,0 +1,234 @@
+#include "ShaderLibrary.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Shader Library constructor
+	/// </summary>
+	/// <param name="device"></param>
+	/// <param name="deletionQueue">Modules released while pipelines are in creation are destroyed later</param>
+	ShaderLibrary::ShaderLibrary(VkDevice device, DeletionQueue* deletionQueue)
+	{
+		m_device = device;
+		m_deletionQueue = deletionQueue;
+		m_fileReads = 0;
+		m_modulesCreated = 0;
+		m_cacheHits = 0;
+	}
+
+	/// <summary>
+	/// Shader Library destructor : no pipeline may be in creation
+	/// </summary>
+	ShaderLibrary::~ShaderLibrary()
+	{
+		if (!m_modules.empty())
+			std::cout << "Loukoum : " << m_modules.size() << " shader modules still referenced on shutdown" << std::endl;
+
+		for (auto& module : m_modules)
+			vkDestroyShaderModule(m_device, module.second.module, nullptr);
+	}
+
+	/// <summary>
+	/// Add a reference to the module of a SPIR-V file, the file is read only if its module does not exist
+	/// </summary>
+	/// <param name="filename">SPIR-V file</param>
+	/// <returns>Handle to release</returns>
+	ShaderHandle ShaderLibrary::acquire(const std::string& filename)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto file = m_files.find(filename);
+			if (file != m_files.end()) {
+				auto module = m_modules.find(file->second);
+				if (module != m_modules.end()) {
+					module->second.refCount++;
+					m_cacheHits++;
+					return file->second;
+				}
+			}
+		}
+
+		//Read outside the lock
+		std::vector<char> code = Utils::readFileBytecode(filename);
+		uint64_t hash = hashCode(code);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_fileReads++;
+		m_files[filename] = hash;
+		return addReference(hash, code);
+	}
+
+	/// <summary>
+	/// Add a reference to the module of SPIR-V code, created only if no module has the same code
+	/// </summary>
+	/// <param name="code">SPIR-V code</param>
+	/// <returns>Handle to release</returns>
+	ShaderHandle ShaderLibrary::acquire(const std::vector<char>& code)
+	{
+		uint64_t hash = hashCode(code);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return addReference(hash, code);
+	}
+
+	/// <summary>
+	/// Add a reference to a module already acquired, kept alive while a pipeline using it is in creation
+	/// </summary>
+	/// <param name="handle"></param>
+	void ShaderLibrary::retain(ShaderHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto module = m_modules.find(handle);
+		if (module == m_modules.end())
+			throw std::runtime_error("Failed to retain shader, unknown handle");
+		module->second.refCount++;
+	}
+
+	/// <summary>
+	/// Release a reference, the module is destroyed with the last one
+	/// </summary>
+	/// <param name="handle"></param>
+	void ShaderLibrary::release(ShaderHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto module = m_modules.find(handle);
+		if (module == m_modules.end())
+			throw std::runtime_error("Failed to release shader, unknown handle");
+
+		if (--module->second.refCount > 0)
+			return;
+
+		m_deletionQueue->pushShaderModule(module->second.module);
+		m_modules.erase(module);
+	}
+
+	/// <summary>
+	/// Get stage info for pipeline creation
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <param name="stage">Vertex, fragment...</param>
+	/// <param name="entryPoint">Must outlive the pipeline creation</param>
+	/// <returns></returns>
+	VkPipelineShaderStageCreateInfo ShaderLibrary::getStage(ShaderHandle handle, VkShaderStageFlagBits stage, const char* entryPoint)
+	{
+		VkPipelineShaderStageCreateInfo shaderStageInfo{};
+		shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStageInfo.stage = stage;
+		shaderStageInfo.module = getModule(handle);
+		shaderStageInfo.pName = entryPoint;
+		return shaderStageInfo;
+	}
+
+	/// <summary>
+	/// Get module of a handle
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns></returns>
+	VkShaderModule ShaderLibrary::getModule(ShaderHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto module = m_modules.find(handle);
+		if (module == m_modules.end())
+			throw std::runtime_error("Failed to get shader module, unknown handle");
+		return module->second.module;
+	}
+
+	/// <summary>
+	/// Get SPIR-V code of a handle
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns></returns>
+	std::vector<char> ShaderLibrary::getCode(ShaderHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto module = m_modules.find(handle);
+		if (module == m_modules.end())
+			throw std::runtime_error("Failed to get shader code, unknown handle");
+		return module->second.code;
+	}
+
+	/// <summary>
+	/// Get interface of a handle : stage, inputs, descriptors and push constants
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns></returns>
+	ShaderInterface ShaderLibrary::getInterface(ShaderHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto module = m_modules.find(handle);
+		if (module == m_modules.end())
+			throw std::runtime_error("Failed to get shader interface, unknown handle");
+		return module->second.shaderInterface;
+	}
+
+	/// <summary>
+	/// Get number of modules alive
+	/// </summary>
+	/// <returns></returns>
+	size_t ShaderLibrary::getModuleCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_modules.size();
+	}
+
+	/// <summary>
+	/// Print files read, modules created and acquisitions served without I/O
+	/// </summary>
+	void ShaderLibrary::printStats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::cout << "Loukoum : shaders, " << m_modules.size() << " modules alive, " << m_modulesCreated << " created, "
+			<< m_fileReads << " files read, " << m_cacheHits << " cache hits" << std::endl;
+	}
+
+	/// <summary>
+	/// Hash SPIR-V code
+	/// </summary>
+	/// <param name="code"></param>
+	/// <returns>Never 0</returns>
+	uint64_t ShaderLibrary::hashCode(const std::vector<char>& code)
+	{
+		uint64_t hash = Utils::hashBytes(Utils::HASH_SEED, code.data(), code.size());
+		return hash != 0 ? hash : 1;
+	}
+
+	/// <summary>
+	/// Add a reference to the module of a hash, create it from the code if missing, lock must be held
+	/// </summary>
+	/// <param name="hash"></param>
+	/// <param name="code"></param>
+	/// <returns></returns>
+	ShaderHandle ShaderLibrary::addReference(uint64_t hash, const std::vector<char>& code)
+	{
+		auto module = m_modules.find(hash);
+		if (module != m_modules.end()) {
+			//Same hash, other code : the module of another shader must not be reused
+			if (module->second.code != code)
+				throw std::runtime_error("Failed to add shader, hash collision");
+			module->second.refCount++;
+			m_cacheHits++;
+			return hash;
+		}
+
+		if (code.empty() || code.size() % 4 != 0)
+			throw std::runtime_error("Failed to create shader module, invalid SPIR-V size");
+
+		//Invalid code throws before a module is created
+		ShaderModuleEntry entry;
+		entry.shaderInterface = ShaderReflection::reflect(code);
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+		if (vkCreateShaderModule(m_device, &createInfo, nullptr, &entry.module) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create shader module!");
+		}
+		entry.code = code;
+		entry.refCount = 1;
+		m_modules[hash] = entry;
+		m_modulesCreated++;
+		return hash;
+	}
+}
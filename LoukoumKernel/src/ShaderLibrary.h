@@ -0,0 +1,85 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+
+#include "Utils.h"
+#include "DeletionQueue.h"
+#include "ShaderReflection.h"
+
+namespace Loukoum
+{
+	//Shader handle : hash of the SPIR-V code, 0 is no shader
+	using ShaderHandle = uint64_t;
+
+	/// <summary>
+	/// Shader module shared by every pipeline using the same SPIR-V code
+	/// </summary>
+	struct ShaderModuleEntry {
+		VkShaderModule module = VK_NULL_HANDLE;
+		uint32_t refCount = 0;
+
+		//Kept for shader objects, created from the code instead of a module
+		std::vector<char> code;
+
+		//Reflected once when the module is created
+		ShaderInterface shaderInterface;
+	};
+
+	/// <summary>
+	/// Shader Library : each SPIR-V file is read once, modules are created once per code hash and reference counted
+	/// Pipelines keep their handles across rebuilds, a module is destroyed once its last reference is released
+	/// </summary>
+	class ShaderLibrary
+	{
+	public:
+		ShaderLibrary(VkDevice device, DeletionQueue* deletionQueue);
+		~ShaderLibrary();
+
+		ShaderLibrary(const ShaderLibrary&) = delete;
+		ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+		//Add a reference, the file or code is only read when it was never seen
+		ShaderHandle acquire(const std::string& filename);
+		ShaderHandle acquire(const std::vector<char>& code);
+		void retain(ShaderHandle handle);
+		void release(ShaderHandle handle);
+
+		//Stage info for pipeline creation
+		VkPipelineShaderStageCreateInfo getStage(ShaderHandle handle, VkShaderStageFlagBits stage, const char* entryPoint = "main");
+		VkShaderModule getModule(ShaderHandle handle);
+		std::vector<char> getCode(ShaderHandle handle);
+		ShaderInterface getInterface(ShaderHandle handle);
+
+		//Stats
+		size_t getModuleCount();
+		void printStats();
+
+		//FNV-1a 64 bits
+		static uint64_t hashCode(const std::vector<char>& code);
+
+	private:
+		ShaderHandle addReference(uint64_t hash, const std::vector<char>& code);
+
+		VkDevice m_device;
+		DeletionQueue* m_deletionQueue;
+
+		std::unordered_map<uint64_t, ShaderModuleEntry> m_modules;
+
+		//File already read : filename to code hash
+		std::unordered_map<std::string, uint64_t> m_files;
+
+		//Stats
+		uint64_t m_fileReads;
+		uint64_t m_modulesCreated;
+		uint64_t m_cacheHits;
+
+		std::mutex m_mutex;
+	};
+}
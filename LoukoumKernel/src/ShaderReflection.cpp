@@ -0,0 +1,464 @@
+#include "ShaderReflection.h"
+
+namespace Loukoum
+{
+	//SPIR-V words read by the reflection
+	static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+	static constexpr uint32_t SPIRV_HEADER_SIZE = 5;
+
+	//Opcodes
+	static constexpr uint32_t OP_ENTRY_POINT = 15;
+	static constexpr uint32_t OP_TYPE_VOID = 19;
+	static constexpr uint32_t OP_TYPE_BOOL = 20;
+	static constexpr uint32_t OP_TYPE_INT = 21;
+	static constexpr uint32_t OP_TYPE_FLOAT = 22;
+	static constexpr uint32_t OP_TYPE_VECTOR = 23;
+	static constexpr uint32_t OP_TYPE_MATRIX = 24;
+	static constexpr uint32_t OP_TYPE_IMAGE = 25;
+	static constexpr uint32_t OP_TYPE_SAMPLER = 26;
+	static constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+	static constexpr uint32_t OP_TYPE_ARRAY = 28;
+	static constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+	static constexpr uint32_t OP_TYPE_STRUCT = 30;
+	static constexpr uint32_t OP_TYPE_POINTER = 32;
+	static constexpr uint32_t OP_CONSTANT = 43;
+	static constexpr uint32_t OP_SPEC_CONSTANT = 50;
+	static constexpr uint32_t OP_FUNCTION = 54;
+	static constexpr uint32_t OP_VARIABLE = 59;
+	static constexpr uint32_t OP_DECORATE = 71;
+	static constexpr uint32_t OP_MEMBER_DECORATE = 72;
+
+	//Decorations
+	static constexpr uint32_t DECORATION_SPEC_ID = 1;
+	static constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+	static constexpr uint32_t DECORATION_ROW_MAJOR = 4;
+	static constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+	static constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+	static constexpr uint32_t DECORATION_BUILT_IN = 11;
+	static constexpr uint32_t DECORATION_LOCATION = 30;
+	static constexpr uint32_t DECORATION_BINDING = 33;
+	static constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+	static constexpr uint32_t DECORATION_OFFSET = 35;
+
+	//Storage classes
+	static constexpr uint32_t STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+	static constexpr uint32_t STORAGE_CLASS_INPUT = 1;
+	static constexpr uint32_t STORAGE_CLASS_UNIFORM = 2;
+	static constexpr uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+	static constexpr uint32_t STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+	//Image dimensions
+	static constexpr uint32_t DIM_BUFFER = 5;
+	static constexpr uint32_t DIM_SUBPASS_DATA = 6;
+
+	/// <summary>
+	/// Decorations of a struct member
+	/// </summary>
+	struct SpirvMember {
+		uint32_t offset = 0;
+		uint32_t matrixStride = 0;
+		bool rowMajor = false;
+	};
+
+	/// <summary>
+	/// Declaration of the module : type, constant or variable, with its decorations
+	/// </summary>
+	struct SpirvId {
+		uint32_t opcode = 0;
+		uint32_t type = 0;				//Result type of constants and variables
+		std::vector<uint32_t> operands;	//Words after the result id
+
+		bool builtIn = false;
+		bool bufferBlock = false;
+		bool hasLocation = false;
+		uint32_t location = 0;
+		bool hasSpecId = false;
+		uint32_t specId = 0;
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		uint32_t arrayStride = 0;
+		std::vector<SpirvMember> members;
+	};
+
+	using SpirvIds = std::unordered_map<uint32_t, SpirvId>;
+
+	/// <summary>
+	/// Get a declaration, throws if the module does not declare it
+	/// </summary>
+	/// <param name="ids"></param>
+	/// <param name="id"></param>
+	/// <returns></returns>
+	static const SpirvId& getId(const SpirvIds& ids, uint32_t id)
+	{
+		auto found = ids.find(id);
+		if (found == ids.end() || found->second.opcode == 0)
+			throw std::runtime_error("Failed to reflect shader, undeclared id " + std::to_string(id));
+		return found->second;
+	}
+
+	/// <summary>
+	/// Get number of operands a type declaration needs, the ones the reflection reads
+	/// </summary>
+	/// <param name="opcode">OpType*</param>
+	/// <returns></returns>
+	static size_t getMinOperandCount(uint32_t opcode)
+	{
+		switch (opcode) {
+		case OP_TYPE_FLOAT:				//Width
+		case OP_TYPE_SAMPLED_IMAGE:		//Image type
+		case OP_TYPE_RUNTIME_ARRAY:		//Element type
+			return 1;
+		case OP_TYPE_INT:				//Width, signedness
+		case OP_TYPE_VECTOR:			//Component type, count
+		case OP_TYPE_MATRIX:			//Column type, count
+		case OP_TYPE_ARRAY:				//Element type, length
+		case OP_TYPE_POINTER:			//Storage class, type
+			return 2;
+		case OP_TYPE_IMAGE:				//Sampled type, dim, depth, arrayed, multisampled, sampled
+			return 6;
+		default:
+			return 0;
+		}
+	}
+
+	/// <summary>
+	/// Get value of an integer constant, default value for specialization constants
+	/// </summary>
+	/// <param name="ids"></param>
+	/// <param name="id"></param>
+	/// <returns></returns>
+	static uint32_t getConstant(const SpirvIds& ids, uint32_t id)
+	{
+		const SpirvId& constant = getId(ids, id);
+		if ((constant.opcode != OP_CONSTANT && constant.opcode != OP_SPEC_CONSTANT) || constant.operands.empty())
+			throw std::runtime_error("Failed to reflect shader, array length is not a constant");
+		return constant.operands[0];
+	}
+
+	/// <summary>
+	/// Get stage of an execution model
+	/// </summary>
+	/// <param name="executionModel"></param>
+	/// <returns></returns>
+	static VkShaderStageFlagBits getStage(uint32_t executionModel)
+	{
+		switch (executionModel) {
+		case 0:
+			return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1:
+			return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2:
+			return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3:
+			return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4:
+			return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5:
+			return VK_SHADER_STAGE_COMPUTE_BIT;
+		default:
+			throw std::runtime_error("Failed to reflect shader, unsupported execution model");
+		}
+	}
+
+	/// <summary>
+	/// Get size of a type inside a block, from its offset and stride decorations
+	/// </summary>
+	/// <param name="ids"></param>
+	/// <param name="typeId"></param>
+	/// <param name="member">Decorations of the struct member holding the type, for matrices</param>
+	/// <returns>Size in bytes</returns>
+	static uint32_t getTypeSize(const SpirvIds& ids, uint32_t typeId, const SpirvMember* member)
+	{
+		const SpirvId& type = getId(ids, typeId);
+		switch (type.opcode) {
+		case OP_TYPE_BOOL:
+			return 4;
+		case OP_TYPE_INT:
+		case OP_TYPE_FLOAT:
+			return type.operands[0] / 8;
+		case OP_TYPE_VECTOR:
+			return type.operands[1] * getTypeSize(ids, type.operands[0], nullptr);
+		case OP_TYPE_MATRIX: {
+			//Column major : one stride per column, row major : one per row
+			uint32_t columns = type.operands[1];
+			if (member == nullptr || member->matrixStride == 0)
+				return columns * getTypeSize(ids, type.operands[0], nullptr);
+			const SpirvId& column = getId(ids, type.operands[0]);
+			if (column.opcode != OP_TYPE_VECTOR)
+				throw std::runtime_error("Failed to reflect shader, matrix column is not a vector");
+			uint32_t rows = column.operands[1];
+			return (member->rowMajor ? rows : columns) * member->matrixStride;
+		}
+		case OP_TYPE_ARRAY: {
+			uint32_t length = getConstant(ids, type.operands[1]);
+			uint32_t stride = type.arrayStride != 0 ? type.arrayStride : getTypeSize(ids, type.operands[0], member);
+			return length * stride;
+		}
+		case OP_TYPE_STRUCT: {
+			uint32_t size = 0;
+			for (size_t i = 0; i < type.operands.size(); i++) {
+				SpirvMember memberInfo = i < type.members.size() ? type.members[i] : SpirvMember();
+				size = std::max(size, memberInfo.offset + getTypeSize(ids, type.operands[i], &memberInfo));
+			}
+			return size;
+		}
+		default:
+			throw std::runtime_error("Failed to reflect shader, unsupported type in a block");
+		}
+	}
+
+	/// <summary>
+	/// Get format of a scalar or vector stage input
+	/// </summary>
+	/// <param name="ids"></param>
+	/// <param name="typeId"></param>
+	/// <returns></returns>
+	static VkFormat getInputFormat(const SpirvIds& ids, uint32_t typeId)
+	{
+		static const VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static const VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+		static const VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+		const SpirvId* component = &getId(ids, typeId);
+		uint32_t componentCount = 1;
+		if (component->opcode == OP_TYPE_VECTOR) {
+			componentCount = component->operands[1];
+			component = &getId(ids, component->operands[0]);
+		}
+
+		bool scalar = component->opcode == OP_TYPE_FLOAT || component->opcode == OP_TYPE_INT;
+		if (scalar && component->operands[0] == 32 && componentCount >= 1 && componentCount <= 4) {
+			if (component->opcode == OP_TYPE_FLOAT)
+				return floatFormats[componentCount - 1];
+			return component->operands[1] != 0 ? intFormats[componentCount - 1] : uintFormats[componentCount - 1];
+		}
+		throw std::runtime_error("Failed to reflect shader, unsupported stage input type");
+	}
+
+	/// <summary>
+	/// Get descriptor type of a resource variable
+	/// </summary>
+	/// <param name="ids"></param>
+	/// <param name="typeId">Type without its arrays</param>
+	/// <param name="storageClass"></param>
+	/// <returns></returns>
+	static VkDescriptorType getDescriptorType(const SpirvIds& ids, uint32_t typeId, uint32_t storageClass)
+	{
+		const SpirvId& type = getId(ids, typeId);
+		if (storageClass == STORAGE_CLASS_STORAGE_BUFFER)
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		if (storageClass == STORAGE_CLASS_UNIFORM)
+			return type.bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+		switch (type.opcode) {
+		case OP_TYPE_SAMPLER:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case OP_TYPE_SAMPLED_IMAGE:
+			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case OP_TYPE_IMAGE: {
+			//Operands : sampled type, dim, depth, arrayed, multisampled, sampled (1 sampled, 2 storage)
+			uint32_t dim = type.operands[1];
+			bool storage = type.operands[5] == 2;
+			if (dim == DIM_SUBPASS_DATA)
+				return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			if (dim == DIM_BUFFER)
+				return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		default:
+			throw std::runtime_error("Failed to reflect shader, unsupported descriptor type");
+		}
+	}
+
+	/// <summary>
+	/// Read the interface of SPIR-V code : entry point stage, inputs with a location, descriptors, push constant size and specialization constants
+	/// </summary>
+	/// <param name="code">SPIR-V code</param>
+	/// <returns></returns>
+	ShaderInterface ShaderReflection::reflect(const std::vector<char>& code)
+	{
+		if (code.size() < SPIRV_HEADER_SIZE * 4 || code.size() % 4 != 0)
+			throw std::runtime_error("Failed to reflect shader, invalid SPIR-V size");
+
+		std::vector<uint32_t> words(code.size() / 4);
+		std::memcpy(words.data(), code.data(), code.size());
+		if (words[0] != SPIRV_MAGIC)
+			throw std::runtime_error("Failed to reflect shader, invalid SPIR-V magic number");
+
+		ShaderInterface shaderInterface;
+		SpirvIds ids;
+		bool hasEntryPoint = false;
+
+		//Declarations : types, constants, global variables and decorations come before the first function
+		size_t offset = SPIRV_HEADER_SIZE;
+		while (offset < words.size()) {
+			const uint32_t* instruction = &words[offset];
+			uint32_t opcode = instruction[0] & 0xFFFF;
+			uint32_t wordCount = instruction[0] >> 16;
+			if (wordCount == 0 || offset + wordCount > words.size())
+				throw std::runtime_error("Failed to reflect shader, truncated instruction");
+			if (opcode == OP_FUNCTION)
+				break;
+
+			if (opcode == OP_ENTRY_POINT && !hasEntryPoint) {
+				shaderInterface.stage = getStage(instruction[1]);
+				hasEntryPoint = true;
+			}
+			else if (opcode == OP_DECORATE && wordCount >= 3) {
+				SpirvId& id = ids[instruction[1]];
+				uint32_t value = wordCount > 3 ? instruction[3] : 0;
+				switch (instruction[2]) {
+				case DECORATION_BUFFER_BLOCK:
+					id.bufferBlock = true;
+					break;
+				case DECORATION_ARRAY_STRIDE:
+					id.arrayStride = value;
+					break;
+				case DECORATION_BUILT_IN:
+					id.builtIn = true;
+					break;
+				case DECORATION_LOCATION:
+					id.hasLocation = true;
+					id.location = value;
+					break;
+				case DECORATION_SPEC_ID:
+					id.hasSpecId = true;
+					id.specId = value;
+					break;
+				case DECORATION_BINDING:
+					id.binding = value;
+					break;
+				case DECORATION_DESCRIPTOR_SET:
+					id.set = value;
+					break;
+				}
+			}
+			else if (opcode == OP_MEMBER_DECORATE && wordCount >= 4) {
+				SpirvId& id = ids[instruction[1]];
+				uint32_t member = instruction[2];
+				uint32_t value = wordCount > 4 ? instruction[4] : 0;
+				if (id.members.size() <= member)
+					id.members.resize(member + 1);
+				if (instruction[3] == DECORATION_OFFSET)
+					id.members[member].offset = value;
+				else if (instruction[3] == DECORATION_MATRIX_STRIDE)
+					id.members[member].matrixStride = value;
+				else if (instruction[3] == DECORATION_ROW_MAJOR)
+					id.members[member].rowMajor = true;
+			}
+			else if (opcode >= OP_TYPE_VOID && opcode <= OP_TYPE_POINTER && wordCount >= 2) {
+				//Operands are read without checks afterwards : a truncated declaration is not valid SPIR-V
+				if (wordCount - 2 < getMinOperandCount(opcode))
+					throw std::runtime_error("Failed to reflect shader, truncated type declaration");
+				SpirvId& id = ids[instruction[1]];
+				id.opcode = opcode;
+				id.operands.assign(instruction + 2, instruction + wordCount);
+			}
+			else if ((opcode == OP_CONSTANT || opcode == OP_SPEC_CONSTANT || opcode == OP_VARIABLE) && wordCount >= 3) {
+				SpirvId& id = ids[instruction[2]];
+				id.opcode = opcode;
+				id.type = instruction[1];
+				id.operands.assign(instruction + 3, instruction + wordCount);
+			}
+			offset += wordCount;
+		}
+
+		if (!hasEntryPoint)
+			throw std::runtime_error("Failed to reflect shader, no entry point");
+
+		//Interface variables and specialization constants
+		for (const auto& entry : ids) {
+			const SpirvId& variable = entry.second;
+			if (variable.hasSpecId)
+				shaderInterface.specConstants.push_back(variable.specId);
+			if (variable.opcode != OP_VARIABLE || variable.operands.empty())
+				continue;
+
+			//Pointer operands : storage class, pointed type
+			uint32_t storageClass = variable.operands[0];
+			const SpirvId& pointer = getId(ids, variable.type);
+			if (pointer.opcode != OP_TYPE_POINTER)
+				throw std::runtime_error("Failed to reflect shader, variable type is not a pointer");
+			uint32_t typeId = pointer.operands[1];
+
+			switch (storageClass) {
+			case STORAGE_CLASS_INPUT: {
+				//Built-ins and block members (gl_in) have no location
+				if (!variable.hasLocation || variable.builtIn)
+					break;
+				const SpirvId& type = getId(ids, typeId);
+				if (type.opcode == OP_TYPE_MATRIX) {
+					for (uint32_t column = 0; column < type.operands[1]; column++)
+						shaderInterface.inputs.push_back({ variable.location + column, getInputFormat(ids, type.operands[0]) });
+				}
+				else {
+					shaderInterface.inputs.push_back({ variable.location, getInputFormat(ids, typeId) });
+				}
+				break;
+			}
+			case STORAGE_CLASS_PUSH_CONSTANT:
+				shaderInterface.pushConstantSize = std::max(shaderInterface.pushConstantSize, getTypeSize(ids, typeId, nullptr));
+				break;
+			case STORAGE_CLASS_UNIFORM_CONSTANT:
+			case STORAGE_CLASS_UNIFORM:
+			case STORAGE_CLASS_STORAGE_BUFFER: {
+				ShaderBinding binding;
+				binding.set = variable.set;
+				binding.binding = variable.binding;
+
+				//Arrays of descriptors : one binding, count is the product of the lengths
+				const SpirvId* type = &getId(ids, typeId);
+				while (type->opcode == OP_TYPE_ARRAY || type->opcode == OP_TYPE_RUNTIME_ARRAY) {
+					if (type->opcode == OP_TYPE_RUNTIME_ARRAY)
+						throw std::runtime_error("Failed to reflect shader, runtime descriptor arrays are not supported");
+					binding.count *= getConstant(ids, type->operands[1]);
+					typeId = type->operands[0];
+					type = &getId(ids, typeId);
+				}
+				binding.type = getDescriptorType(ids, typeId, storageClass);
+				shaderInterface.bindings.push_back(binding);
+				break;
+			}
+			}
+		}
+
+		//Ids are hashed : sort for a stable interface
+		std::sort(shaderInterface.inputs.begin(), shaderInterface.inputs.end(), [](const ShaderInput& a, const ShaderInput& b) {
+			return a.location < b.location;
+		});
+		std::sort(shaderInterface.specConstants.begin(), shaderInterface.specConstants.end());
+		std::sort(shaderInterface.bindings.begin(), shaderInterface.bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+		return shaderInterface;
+	}
+
+	/// <summary>
+	/// Get the attributes of a vertex format read by a vertex shader, attributes the shader ignores are left out
+	/// The vertex format gives the buffer layout, the shader which locations are used
+	/// </summary>
+	/// <param name="vertexInterface">Interface of the vertex shader</param>
+	/// <param name="vertexFormat">Vertex format of the vertex buffer</param>
+	/// <returns></returns>
+	std::vector<VkVertexInputAttributeDescription> ShaderReflection::getVertexAttributes(const ShaderInterface& vertexInterface, int vertexFormat)
+	{
+		std::vector<VkVertexInputAttributeDescription> formatAttributes = VertexFormat::getAttributeDescriptions(vertexFormat);
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		for (const ShaderInput& input : vertexInterface.inputs) {
+			auto found = std::find_if(formatAttributes.begin(), formatAttributes.end(), [&input](const VkVertexInputAttributeDescription& attribute) {
+				return attribute.location == input.location;
+			});
+			if (found == formatAttributes.end())
+				throw std::runtime_error("Failed to match vertex input, location " + std::to_string(input.location) + " is not in the vertex format");
+
+			//Vertex formats store floats and normalized integers
+			bool floatInput = input.format == VK_FORMAT_R32_SFLOAT || input.format == VK_FORMAT_R32G32_SFLOAT
+				|| input.format == VK_FORMAT_R32G32B32_SFLOAT || input.format == VK_FORMAT_R32G32B32A32_SFLOAT;
+			if (!floatInput)
+				throw std::runtime_error("Failed to match vertex input, location " + std::to_string(input.location) + " is an integer");
+
+			attributes.push_back(*found);
+		}
+		return attributes;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+#include "VertexFormat.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Stage input : location and the 32 bits format of its GLSL type, matrices take one location per column
+	/// </summary>
+	struct ShaderInput {
+		uint32_t location = 0;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+	};
+
+	/// <summary>
+	/// Descriptor used by a shader
+	/// </summary>
+	struct ShaderBinding {
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uint32_t count = 1;
+	};
+
+	/// <summary>
+	/// Interface of a shader read from its SPIR-V : stage, inputs, descriptors, push constants and specialization constants
+	/// </summary>
+	struct ShaderInterface {
+		VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+		std::vector<ShaderInput> inputs;		//By location
+		std::vector<ShaderBinding> bindings;	//By set, then binding
+		uint32_t pushConstantSize = 0;			//0 without push constant block
+		std::vector<uint32_t> specConstants;	//Specialization constant ids, sorted
+	};
+
+	/// <summary>
+	/// Shader Reflection : reads the interface of SPIR-V code, so pipelines need no hand-written binding code
+	/// Only the declarations are parsed, function bodies are skipped
+	/// </summary>
+	class ShaderReflection
+	{
+	public:
+		//Throws if the code is not valid SPIR-V or uses an unsupported interface
+		static ShaderInterface reflect(const std::vector<char>& code);
+
+		//Attributes of a vertex format read by a vertex shader, throws if the format lacks an input
+		static std::vector<VkVertexInputAttributeDescription> getVertexAttributes(const ShaderInterface& vertexInterface, int vertexFormat);
+	};
+}
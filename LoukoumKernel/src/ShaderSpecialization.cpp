@@ -0,0 +1,156 @@
+#include "ShaderSpecialization.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Set a constant from its 32 bits
+	/// </summary>
+	/// <param name="id">constant_id of the shader</param>
+	/// <param name="value"></param>
+	void ShaderSpecialization::set(uint32_t id, uint32_t value)
+	{
+		size_t index = 0;
+		while (index < m_entries.size() && m_entries[index].constantID < id)
+			index++;
+
+		if (index < m_entries.size() && m_entries[index].constantID == id) {
+			m_data[index] = value;
+			return;
+		}
+
+		VkSpecializationMapEntry entry{};
+		entry.constantID = id;
+		entry.size = sizeof(uint32_t);
+		m_entries.insert(m_entries.begin() + index, entry);
+		m_data.insert(m_data.begin() + index, value);
+
+		//Offsets follow the order of the data
+		for (size_t i = 0; i < m_entries.size(); i++)
+			m_entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+	}
+
+	/// <summary>
+	/// Set an int constant
+	/// </summary>
+	/// <param name="id">constant_id of the shader</param>
+	/// <param name="value"></param>
+	void ShaderSpecialization::set(uint32_t id, int32_t value)
+	{
+		set(id, static_cast<uint32_t>(value));
+	}
+
+	/// <summary>
+	/// Set a float constant
+	/// </summary>
+	/// <param name="id">constant_id of the shader</param>
+	/// <param name="value"></param>
+	void ShaderSpecialization::set(uint32_t id, float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		set(id, bits);
+	}
+
+	/// <summary>
+	/// Set a bool constant
+	/// </summary>
+	/// <param name="id">constant_id of the shader</param>
+	/// <param name="value"></param>
+	void ShaderSpecialization::set(uint32_t id, bool value)
+	{
+		set(id, static_cast<uint32_t>(value ? VK_TRUE : VK_FALSE));
+	}
+
+	/// <summary>
+	/// Check if no constant is set : the shader defaults are used
+	/// </summary>
+	/// <returns></returns>
+	bool ShaderSpecialization::isEmpty() const
+	{
+		return m_entries.empty();
+	}
+
+	/// <summary>
+	/// Get map entries, sorted by constant id
+	/// </summary>
+	/// <returns></returns>
+	const std::vector<VkSpecializationMapEntry>& ShaderSpecialization::getEntries() const
+	{
+		return m_entries;
+	}
+
+	/// <summary>
+	/// Get the 32 bits of a constant
+	/// </summary>
+	/// <param name="index">Index in the entries</param>
+	/// <returns></returns>
+	uint32_t ShaderSpecialization::getValue(size_t index) const
+	{
+		return m_data.at(index);
+	}
+
+	/// <summary>
+	/// Get the Vulkan specialization info
+	/// </summary>
+	/// <returns></returns>
+	VkSpecializationInfo ShaderSpecialization::getInfo() const
+	{
+		VkSpecializationInfo info{};
+		info.mapEntryCount = static_cast<uint32_t>(m_entries.size());
+		info.pMapEntries = m_entries.data();
+		info.dataSize = m_data.size() * sizeof(uint32_t);
+		info.pData = m_data.data();
+		return info;
+	}
+
+	/// <summary>
+	/// Check the constants against the constant ids declared by the shader
+	/// Vulkan ignores unknown ids : a typo would silently keep the default value
+	/// </summary>
+	/// <param name="shaderInterface">Interface of the specialized shader</param>
+	void ShaderSpecialization::check(const ShaderInterface& shaderInterface) const
+	{
+		for (const VkSpecializationMapEntry& entry : m_entries) {
+			if (std::find(shaderInterface.specConstants.begin(), shaderInterface.specConstants.end(), entry.constantID) == shaderInterface.specConstants.end())
+				throw std::runtime_error("Failed to specialize shader, constant " + std::to_string(entry.constantID) + " is not declared");
+		}
+	}
+
+	/// <summary>
+	/// Hash of the constant ids and values, FNV-1a
+	/// </summary>
+	/// <returns></returns>
+	uint64_t ShaderSpecialization::getHash() const
+	{
+		uint64_t hash = Utils::HASH_SEED;
+		for (size_t i = 0; i < m_entries.size(); i++)
+			hash = Utils::hashValue(hash, ((uint64_t)m_entries[i].constantID << 32) | m_data[i]);
+		return hash;
+	}
+
+	/// <summary>
+	/// Compare constant ids and values
+	/// </summary>
+	/// <param name="other"></param>
+	/// <returns></returns>
+	bool ShaderSpecialization::operator==(const ShaderSpecialization& other) const
+	{
+		if (m_data != other.m_data || m_entries.size() != other.m_entries.size())
+			return false;
+		for (size_t i = 0; i < m_entries.size(); i++) {
+			if (m_entries[i].constantID != other.m_entries[i].constantID)
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Compare constant ids and values
+	/// </summary>
+	/// <param name="other"></param>
+	/// <returns></returns>
+	bool ShaderSpecialization::operator!=(const ShaderSpecialization& other) const
+	{
+		return !(*this == other);
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+
+#include "ShaderReflection.h"
+#include "Utils.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Shader Specialization : values of the specialization constants of one stage
+	/// One SPIR-V is compiled into a pipeline per set of values, the driver folds the constants (light counts, toggles, loop bounds)
+	/// Constants are 32 bits, bools are VkBool32, kept sorted by constant id
+	/// </summary>
+	class ShaderSpecialization
+	{
+	public:
+		//Set a constant, replaces a previous value
+		void set(uint32_t id, uint32_t value);
+		void set(uint32_t id, int32_t value);
+		void set(uint32_t id, float value);
+		void set(uint32_t id, bool value);
+
+		bool isEmpty() const;
+		const std::vector<VkSpecializationMapEntry>& getEntries() const;
+		uint32_t getValue(size_t index) const;
+
+		//Points to this object, valid until it is modified
+		VkSpecializationInfo getInfo() const;
+
+		//Throws if a constant is not declared by the shader
+		void check(const ShaderInterface& shaderInterface) const;
+
+		uint64_t getHash() const;
+		bool operator==(const ShaderSpecialization& other) const;
+		bool operator!=(const ShaderSpecialization& other) const;
+
+	private:
+		std::vector<VkSpecializationMapEntry> m_entries;
+		std::vector<uint32_t> m_data;
+	};
+}
@@ -0,0 +1,145 @@
+#include "ThreadPool.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Thread Pool constructor : start worker threads
+	/// </summary>
+	/// <param name="threadCount">Worker threads besides the caller, 0 for one per remaining core</param>
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		m_generation = 0;
+		m_stop = false;
+
+		if (threadCount == 0) {
+			uint32_t cores = std::thread::hardware_concurrency();
+			threadCount = cores > 1 ? cores - 1 : 1;
+		}
+
+		//Worker 0 is the thread calling parallelFor
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_threads.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+	}
+
+	/// <summary>
+	/// Thread Pool destructor : stop and join worker threads
+	/// </summary>
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wakeCondition.notify_all();
+
+		for (std::thread& thread : m_threads)
+			thread.join();
+	}
+
+	/// <summary>
+	/// Run a task over [0, count) on all workers, chunks are given in order to the first free worker
+	/// Exceptions thrown by the task are rethrown once all chunks are done
+	/// </summary>
+	/// <param name="count">Number of items</param>
+	/// <param name="chunkSize">Items per task call</param>
+	/// <param name="task">Task, called from several threads at once</param>
+	void ThreadPool::parallelFor(size_t count, size_t chunkSize, const ParallelTask& task)
+	{
+		if (count == 0)
+			return;
+
+		std::shared_ptr<ParallelJob> job = std::make_shared<ParallelJob>();
+		job->task = &task;
+		job->count = count;
+		job->chunkSize = std::max<size_t>(chunkSize, 1);
+		job->chunkCount = (count + job->chunkSize - 1) / job->chunkSize;
+		job->pendingChunks = job->chunkCount;
+
+		//A single chunk isn't worth waking threads
+		if (job->chunkCount > 1)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_job = job;
+				m_generation++;
+			}
+			m_wakeCondition.notify_all();
+		}
+
+		runChunks(*job, 0);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_doneCondition.wait(lock, [&job] { return job->pendingChunks == 0; });
+		if (m_job == job)
+			m_job.reset();
+
+		if (job->error)
+			std::rethrow_exception(job->error);
+	}
+
+	/// <summary>
+	/// Get number of threads running tasks, the caller included
+	/// </summary>
+	/// <returns></returns>
+	uint32_t ThreadPool::getWorkerCount() const
+	{
+		return static_cast<uint32_t>(m_threads.size()) + 1;
+	}
+
+	/// <summary>
+	/// Worker thread : wait for a job, help running it, repeat
+	/// </summary>
+	/// <param name="worker">Worker index</param>
+	void ThreadPool::workerLoop(uint32_t worker)
+	{
+		uint64_t generation = 0;
+		while (true)
+		{
+			std::shared_ptr<ParallelJob> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wakeCondition.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+				if (m_stop)
+					return;
+				generation = m_generation;
+				job = m_job;
+			}
+
+			//The job may be finished already
+			if (job != nullptr)
+				runChunks(*job, worker);
+		}
+	}
+
+	/// <summary>
+	/// Take chunks of a job until none is left
+	/// </summary>
+	/// <param name="job"></param>
+	/// <param name="worker">Worker index given to the task</param>
+	void ThreadPool::runChunks(ParallelJob& job, uint32_t worker)
+	{
+		while (true)
+		{
+			size_t chunk = job.nextChunk.fetch_add(1);
+			if (chunk >= job.chunkCount)
+				return;
+
+			size_t begin = chunk * job.chunkSize;
+			size_t end = std::min(begin + job.chunkSize, job.count);
+			try {
+				(*job.task)(begin, end, worker);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!job.error)
+					job.error = std::current_exception();
+			}
+
+			//Last chunk : wake the caller
+			if (job.pendingChunks.fetch_sub(1) == 1) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_doneCondition.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <exception>
+
+namespace Loukoum
+{
+	//Runs items [begin, end), worker is the index of the running thread, 0 for the caller
+	using ParallelTask = std::function<void(size_t begin, size_t end, uint32_t worker)>;
+
+	/// <summary>
+	/// Chunks of a parallelFor call, shared by the threads running it
+	/// </summary>
+	struct ParallelJob {
+		const ParallelTask* task = nullptr;
+		size_t count = 0;
+		size_t chunkSize = 0;
+		size_t chunkCount = 0;
+		std::atomic<size_t> nextChunk{ 0 };
+		std::atomic<size_t> pendingChunks{ 0 };
+
+		//First exception thrown by a chunk, rethrown to the caller
+		std::exception_ptr error;
+	};
+
+	/// <summary>
+	/// Thread Pool : fixed worker threads splitting loops in chunks, the calling thread works too
+	/// </summary>
+	class ThreadPool
+	{
+	public:
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		//Run task on [0, count) in chunks of chunkSize items, returns once all chunks are done
+		void parallelFor(size_t count, size_t chunkSize, const ParallelTask& task);
+
+		//Threads running tasks, the caller included : worker indices are below this count
+		uint32_t getWorkerCount() const;
+
+	private:
+		void workerLoop(uint32_t worker);
+		void runChunks(ParallelJob& job, uint32_t worker);
+
+		std::vector<std::thread> m_threads;
+
+		//Current job, replaced by each parallelFor
+		std::shared_ptr<ParallelJob> m_job;
+		uint64_t m_generation;
+		bool m_stop;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wakeCondition;
+		std::condition_variable m_doneCondition;
+	};
+}
@@ -0,0 +1,147 @@
+#include "Timeline.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Timeline constructor : create the timeline semaphore at value 0
+	/// </summary>
+	/// <param name="device">Device with the timelineSemaphore feature enabled</param>
+	Timeline::Timeline(VkDevice device)
+	{
+		m_device = device;
+		m_lastSubmitted = 0;
+		m_completed = 0;
+
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+		if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create timeline semaphore");
+		}
+	}
+
+	/// <summary>
+	/// Timeline destructor : GPU must be idle
+	/// </summary>
+	Timeline::~Timeline()
+	{
+		vkDestroySemaphore(m_device, m_semaphore, nullptr);
+	}
+
+	/// <summary>
+	/// Submit a batch signaling the next timeline value, waited binary semaphores and signaled binary semaphores are kept
+	/// All submissions signaling the timeline must go to the same queue
+	/// </summary>
+	/// <param name="queue"></param>
+	/// <param name="submitInfo">Submission without pNext</param>
+	/// <returns>Value signaled once the batch is done</returns>
+	uint64_t Timeline::submit(VkQueue queue, const VkSubmitInfo& submitInfo)
+	{
+		std::lock_guard<std::mutex> lock(m_submitMutex);
+		uint64_t value = m_lastSubmitted + 1;
+
+		//Timeline semaphore after the binary ones, binary values are ignored
+		std::vector<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+		signalSemaphores.push_back(m_semaphore);
+		std::vector<uint64_t> signalValues(signalSemaphores.size(), 0);
+		signalValues.back() = value;
+		std::vector<uint64_t> waitValues(submitInfo.waitSemaphoreCount, 0);
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+		timelineInfo.pWaitSemaphoreValues = waitValues.data();
+		timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+		timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+		VkSubmitInfo timelineSubmitInfo = submitInfo;
+		timelineSubmitInfo.pNext = &timelineInfo;
+		timelineSubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+		timelineSubmitInfo.pSignalSemaphores = signalSemaphores.data();
+		if (vkQueueSubmit(queue, 1, &timelineSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to submit to the timeline");
+		}
+
+		m_lastSubmitted = value;
+		return value;
+	}
+
+	/// <summary>
+	/// Get the value reached by the GPU, never blocks
+	/// </summary>
+	/// <returns></returns>
+	uint64_t Timeline::getCompletedValue()
+	{
+		uint64_t value = 0;
+		if (vkGetSemaphoreCounterValue(m_device, m_semaphore, &value) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to get timeline semaphore value");
+		}
+
+		setCompleted(value);
+		return value;
+	}
+
+	/// <summary>
+	/// Check if the GPU reached a value
+	/// </summary>
+	/// <param name="value"></param>
+	/// <returns></returns>
+	bool Timeline::isComplete(uint64_t value)
+	{
+		return m_completed >= value || getCompletedValue() >= value;
+	}
+
+	/// <summary>
+	/// Block until the GPU reaches a value, it must be submitted already
+	/// </summary>
+	/// <param name="value"></param>
+	void Timeline::wait(uint64_t value)
+	{
+		if (m_completed >= value)
+			return;
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_semaphore;
+		waitInfo.pValues = &value;
+		if (vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to wait timeline semaphore");
+		}
+
+		setCompleted(value);
+	}
+
+	/// <summary>
+	/// Get timeline semaphore
+	/// </summary>
+	/// <returns></returns>
+	VkSemaphore Timeline::getSemaphore() const
+	{
+		return m_semaphore;
+	}
+
+	/// <summary>
+	/// Get value signaled by the last submission, reached once everything submitted so far is done
+	/// </summary>
+	/// <returns></returns>
+	uint64_t Timeline::getLastSubmitted() const
+	{
+		return m_lastSubmitted;
+	}
+
+	/// <summary>
+	/// Keep the highest value known reached, values read by other threads may be older
+	/// </summary>
+	/// <param name="value"></param>
+	void Timeline::setCompleted(uint64_t value)
+	{
+		uint64_t completed = m_completed;
+		while (completed < value && !m_completed.compare_exchange_weak(completed, value));
+	}
+}
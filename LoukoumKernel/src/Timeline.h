@@ -0,0 +1,51 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Timeline : one timeline semaphore signaled by every submission to the graphics queue
+	/// Each submission signals the next value, the CPU waits on exact values instead of fences (Vulkan 1.2)
+	/// </summary>
+	class Timeline
+	{
+	public:
+		Timeline(VkDevice device);
+		~Timeline();
+
+		Timeline(const Timeline&) = delete;
+		Timeline& operator=(const Timeline&) = delete;
+
+		//Submit, the timeline semaphore is added to the signaled semaphores, returns the value signaled
+		uint64_t submit(VkQueue queue, const VkSubmitInfo& submitInfo);
+
+		//Completion
+		uint64_t getCompletedValue();
+		bool isComplete(uint64_t value);
+		void wait(uint64_t value);
+
+		//Getters
+		VkSemaphore getSemaphore() const;
+		uint64_t getLastSubmitted() const;
+
+	private:
+		void setCompleted(uint64_t value);
+
+		VkDevice m_device;
+		VkSemaphore m_semaphore;
+
+		//Last value given to a submission, and last value known reached
+		std::atomic<uint64_t> m_lastSubmitted;
+		std::atomic<uint64_t> m_completed;
+
+		//Values must be signaled in submission order
+		std::mutex m_submitMutex;
+	};
+}
@@ -0,0 +1,657 @@
+#include "UploadManager.h"
+
+namespace Loukoum
+{
+	//Stages and accesses of the graphics queue reading uploaded resources
+	static const VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	static const VkAccessFlags CONSUMER_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	/// <summary>
+	/// Upload Manager constructor : create staging ring and command pools
+	/// </summary>
+	/// <param name="device"></param>
+	/// <param name="allocator">Allocator of the staging ring</param>
+	/// <param name="transferFamily">Queue family of the copy queue</param>
+	/// <param name="transferQueue">Queue used to submit copies</param>
+	/// <param name="graphicsFamily">Queue family using uploaded resources</param>
+	/// <param name="graphicsQueue">Queue using uploaded resources</param>
+	/// <param name="queueMutex">Mutex held by every submission to the queues</param>
+	/// <param name="timeline">Graphics queue timeline, nullptr to use fences</param>
+	/// <param name="ringSize">Staging ring size</param>
+	UploadManager::UploadManager(VkDevice device, MemoryAllocator* allocator, uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily, VkQueue graphicsQueue, std::mutex* queueMutex, Timeline* timeline, VkDeviceSize ringSize)
+	{
+		m_device = device;
+		m_allocator = allocator;
+		m_transferQueue = transferQueue;
+		m_graphicsQueue = graphicsQueue;
+		m_transferFamily = transferFamily;
+		m_graphicsFamily = graphicsFamily;
+		m_separateQueue = transferQueue != graphicsQueue;
+		m_ownershipTransfer = transferFamily != graphicsFamily;
+		m_acquireCommandPool = VK_NULL_HANDLE;
+		m_timeline = timeline;
+		m_queueMutex = queueMutex;
+		m_ringSize = ringSize;
+		m_ringHead = 0;
+		m_ringTail = 0;
+		m_nextTicket = 1;
+		m_completedTicket = 0;
+
+		//Command pool of short lived command buffers
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = m_transferFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create upload Command Pool");
+		}
+
+		//Command pool of the graphics queue side of the hand over
+		if (m_separateQueue)
+		{
+			poolInfo.queueFamilyIndex = m_graphicsFamily;
+			if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_acquireCommandPool) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create upload acquire Command Pool");
+			}
+		}
+
+		//Staging ring, persistently mapped, read by both families when they differ
+		std::vector<uint32_t> stagingFamilies;
+		if (m_ownershipTransfer)
+			stagingFamilies = { m_transferFamily, m_graphicsFamily };
+		m_stagingBuffer = m_allocator->createBuffer(m_ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_stagingAllocation, MEMORY_CATEGORY_STAGING, MEMORY_PRIORITY_HIGH, stagingFamilies);
+
+		beginBatch();
+	}
+
+	/// <summary>
+	/// Upload Manager destructor : wait pending copies and free resources
+	/// </summary>
+	UploadManager::~UploadManager()
+	{
+		waitIdle();
+
+		m_freeBatches.push_back(m_currentBatch);
+		for (UploadBatch& batch : m_freeBatches)
+		{
+			if (batch.fence != VK_NULL_HANDLE)
+				vkDestroyFence(m_device, batch.fence, nullptr);
+			if (batch.semaphore != VK_NULL_HANDLE)
+				vkDestroySemaphore(m_device, batch.semaphore, nullptr);
+		}
+
+		vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+		if (m_acquireCommandPool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(m_device, m_acquireCommandPool, nullptr);
+		m_allocator->destroyBuffer(m_stagingBuffer, m_stagingAllocation);
+	}
+
+	/// <summary>
+	/// Copy data to a buffer, large data is split in several ring chunks
+	/// </summary>
+	/// <param name="dstBuffer">Destination buffer, needs TRANSFER_DST usage</param>
+	/// <param name="dstOffset">Offset in destination buffer</param>
+	/// <param name="data">Source data, can be freed on return</param>
+	/// <param name="size">Data size</param>
+	/// <returns>Ticket of the batch holding the copy</returns>
+	uint64_t UploadManager::upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+	{
+		const char* src = static_cast<const char*>(data);
+		return uploadWith(dstBuffer, dstOffset, 1, (size_t)size, [src](void* dst, size_t first, size_t count) {
+			memcpy(dst, src + first, count);
+		});
+	}
+
+	/// <summary>
+	/// Copy elements to a buffer, the writer fills the mapped staging ring directly
+	/// The writer is called once per ring chunk, chunks never split an element
+	/// </summary>
+	/// <param name="dstBuffer">Destination buffer, needs TRANSFER_DST usage</param>
+	/// <param name="dstOffset">Offset in destination buffer</param>
+	/// <param name="elementSize">Size of one element</param>
+	/// <param name="elementCount">Number of elements</param>
+	/// <param name="writer">Writes elements [first, first + count) to dst</param>
+	/// <returns>Ticket of the batch holding the last copy</returns>
+	uint64_t UploadManager::uploadWith(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize elementSize, size_t elementCount, const UploadWriter& writer)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		size_t maxChunkElements = (size_t)std::max<VkDeviceSize>(1, (m_ringSize / 4) / elementSize);
+		size_t first = 0;
+
+		while (first < elementCount)
+		{
+			//Fill staging ring
+			size_t count = std::min(elementCount - first, maxChunkElements);
+			VkDeviceSize chunk = count * elementSize;
+			VkDeviceSize ringOffset = reserve(chunk, 16);
+			writer(static_cast<char*>(m_stagingAllocation.mappedData) + ringOffset, first, count);
+
+			//Record copy from ring to destination
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = ringOffset;
+			copyRegion.dstOffset = dstOffset + first * elementSize;
+			copyRegion.size = chunk;
+			vkCmdCopyBuffer(m_currentBatch.commandBuffer, m_stagingBuffer, dstBuffer, 1, &copyRegion);
+
+			//Written range, access masks are set on submit
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = m_ownershipTransfer ? m_transferFamily : VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = m_ownershipTransfer ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer = dstBuffer;
+			barrier.offset = copyRegion.dstOffset;
+			barrier.size = chunk;
+			m_currentBatch.bufferBarriers.push_back(barrier);
+
+			m_currentBatch.copyCount++;
+			m_currentBatch.ringEnd = m_ringHead;
+
+			first += count;
+		}
+
+		return m_currentBatch.ticket;
+	}
+
+	/// <summary>
+	/// Copy texels to the first mip level of a 2D color image, data must fit in the staging ring
+	/// </summary>
+	/// <param name="dstImage">Destination image, needs TRANSFER_DST usage</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="finalLayout">Layout of the image when used by the graphics queue</param>
+	/// <param name="data">Tightly packed texels, can be freed on return</param>
+	/// <param name="size">Data size</param>
+	/// <returns>Ticket of the batch holding the copy</returns>
+	uint64_t UploadManager::uploadImage(VkImage dstImage, uint32_t width, uint32_t height, VkImageLayout finalLayout, const void* data, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		//Copy in staging ring
+		VkDeviceSize ringOffset = reserve(size, 16);
+		memcpy(static_cast<char*>(m_stagingAllocation.mappedData) + ringOffset, data, (size_t)size);
+
+		//Whole color image
+		VkImageSubresourceRange range{};
+		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		range.baseMipLevel = 0;
+		range.levelCount = 1;
+		range.baseArrayLayer = 0;
+		range.layerCount = 1;
+
+		//Layout for copy
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = dstImage;
+		barrier.subresourceRange = range;
+		vkCmdPipelineBarrier(m_currentBatch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		//Record copy from ring to image
+		VkBufferImageCopy copyRegion{};
+		copyRegion.bufferOffset = ringOffset;
+		copyRegion.bufferRowLength = 0;
+		copyRegion.bufferImageHeight = 0;
+		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.imageSubresource.mipLevel = 0;
+		copyRegion.imageSubresource.baseArrayLayer = 0;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageOffset = { 0, 0, 0 };
+		copyRegion.imageExtent = { width, height, 1 };
+		vkCmdCopyBufferToImage(m_currentBatch.commandBuffer, m_stagingBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+		//Transition to final layout, access masks are set on submit
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = finalLayout;
+		barrier.srcQueueFamilyIndex = m_ownershipTransfer ? m_transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = m_ownershipTransfer ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		m_currentBatch.imageBarriers.push_back(barrier);
+
+		m_currentBatch.copyCount++;
+		m_currentBatch.ringEnd = m_ringHead;
+
+		return m_currentBatch.ticket;
+	}
+
+	/// <summary>
+	/// Rewrite part of a buffer the graphics queue already uses, large data is split in several ring chunks
+	/// The copy is recorded on the graphics queue : the buffer stays owned by the graphics family
+	/// </summary>
+	/// <param name="dstBuffer">Destination buffer, needs TRANSFER_DST usage</param>
+	/// <param name="dstOffset">Offset in destination buffer</param>
+	/// <param name="data">Source data, can be freed on return</param>
+	/// <param name="size">Data size</param>
+	/// <returns>Ticket of the batch holding the copy</returns>
+	uint64_t UploadManager::update(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const char* src = static_cast<const char*>(data);
+		VkDeviceSize maxChunk = m_ringSize / 4;
+		VkDeviceSize first = 0;
+
+		while (first < size)
+		{
+			//Fill staging ring
+			VkDeviceSize chunk = std::min(size - first, maxChunk);
+			VkDeviceSize ringOffset = reserve(chunk, 16);
+			memcpy(static_cast<char*>(m_stagingAllocation.mappedData) + ringOffset, src + first, (size_t)chunk);
+
+			//Recorded on submit, after the copies of the transfer queue
+			UploadUpdate update;
+			update.buffer = dstBuffer;
+			update.region.srcOffset = ringOffset;
+			update.region.dstOffset = dstOffset + first;
+			update.region.size = chunk;
+			m_currentBatch.updates.push_back(update);
+			m_currentBatch.ringEnd = m_ringHead;
+
+			first += chunk;
+		}
+
+		return m_currentBatch.ticket;
+	}
+
+	/// <summary>
+	/// Submit all copies recorded since the last flush in one submission
+	/// </summary>
+	/// <returns>Ticket of the submitted batch</returns>
+	uint64_t UploadManager::flush()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return submit();
+	}
+
+	/// <summary>
+	/// Retire finished batches and give back their ring space, never blocks
+	/// </summary>
+	void UploadManager::collect()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		while (!m_inFlightBatches.empty() && isBatchComplete(m_inFlightBatches.front()))
+			retireFront();
+	}
+
+	/// <summary>
+	/// Is the batch of ticket and all batches before it finished on GPU
+	/// </summary>
+	/// <param name="ticket"></param>
+	/// <returns></returns>
+	bool UploadManager::isComplete(uint64_t ticket)
+	{
+		collect();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_completedTicket >= ticket;
+	}
+
+	/// <summary>
+	/// Block until the batch of ticket is finished, submit it if needed
+	/// </summary>
+	/// <param name="ticket"></param>
+	void UploadManager::wait(uint64_t ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (ticket >= m_currentBatch.ticket)
+			submit();
+
+		while (m_completedTicket < ticket && !m_inFlightBatches.empty())
+		{
+			waitBatch(m_inFlightBatches.front());
+			retireFront();
+		}
+	}
+
+	/// <summary>
+	/// Submit and wait all uploads
+	/// </summary>
+	void UploadManager::waitIdle()
+	{
+		wait(m_currentBatch.ticket);
+	}
+
+	/// <summary>
+	/// Reserve ring space, wait for old batches when the ring is full
+	/// </summary>
+	/// <param name="size"></param>
+	/// <param name="alignment"></param>
+	/// <returns>Physical offset in the staging buffer</returns>
+	VkDeviceSize UploadManager::reserve(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (size > m_ringSize)
+			throw std::runtime_error("Staging ring too small for upload");
+
+		while (true)
+		{
+			//Align and skip the end of the ring if data doesn't fit before wrapping
+			uint64_t head = (m_ringHead + alignment - 1) / alignment * alignment;
+			VkDeviceSize physical = head % m_ringSize;
+			if (physical + size > m_ringSize)
+				head += m_ringSize - physical;
+
+			//Enough space after the oldest batch still in use
+			if (head + size - m_ringTail <= m_ringSize)
+			{
+				m_ringHead = head + size;
+				return head % m_ringSize;
+			}
+
+			//Ring full : free space by retiring the oldest batches
+			if (!m_inFlightBatches.empty())
+			{
+				waitBatch(m_inFlightBatches.front());
+				retireFront();
+			}
+			else if (m_currentBatch.copyCount > 0 || !m_currentBatch.updates.empty())
+				submit();
+			else
+				m_ringHead = m_ringTail = (m_ringHead + m_ringSize - 1) / m_ringSize * m_ringSize;
+		}
+	}
+
+	/// <summary>
+	/// Submit the current batch and start a new one
+	/// </summary>
+	/// <returns>Ticket of the submitted batch</returns>
+	uint64_t UploadManager::submit()
+	{
+		if (m_currentBatch.copyCount == 0 && m_currentBatch.updates.empty())
+			return m_currentBatch.ticket - 1;
+
+		//Transfer side : end of copies, a shared queue also runs the updates
+		recordRelease();
+		if (!m_separateQueue)
+			recordUpdates(m_currentBatch.commandBuffer);
+		if (vkEndCommandBuffer(m_currentBatch.commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to end upload command buffer recording");
+		}
+
+		//Any uploading thread can get here : the queues are shared with the frame submission
+		std::lock_guard<std::mutex> queueLock(*m_queueMutex);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_currentBatch.commandBuffer;
+		if (!m_separateQueue)
+		{
+			if (m_timeline != nullptr)
+				m_currentBatch.timelineValue = m_timeline->submit(m_transferQueue, submitInfo);
+			else if (vkQueueSubmit(m_transferQueue, 1, &submitInfo, m_currentBatch.fence) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to submit upload Command Buffer");
+			}
+		}
+		else
+		{
+			//Copies on the transfer queue, a batch of updates only has none
+			bool transferCopies = m_currentBatch.copyCount > 0;
+			if (transferCopies) {
+				submitInfo.signalSemaphoreCount = 1;
+				submitInfo.pSignalSemaphores = &m_currentBatch.semaphore;
+				if (vkQueueSubmit(m_transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to submit upload Command Buffer");
+				}
+			}
+
+			//Graphics side : wait copies, take the resources and run the updates
+			recordAcquire();
+
+			VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			VkSubmitInfo acquireInfo{};
+			acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			acquireInfo.waitSemaphoreCount = transferCopies ? 1 : 0;
+			acquireInfo.pWaitSemaphores = &m_currentBatch.semaphore;
+			acquireInfo.pWaitDstStageMask = &waitStage;
+			acquireInfo.commandBufferCount = 1;
+			acquireInfo.pCommandBuffers = &m_currentBatch.acquireCommandBuffer;
+			if (m_timeline != nullptr)
+				m_currentBatch.timelineValue = m_timeline->submit(m_graphicsQueue, acquireInfo);
+			else if (vkQueueSubmit(m_graphicsQueue, 1, &acquireInfo, m_currentBatch.fence) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to submit upload acquire Command Buffer");
+			}
+		}
+
+		uint64_t ticket = m_currentBatch.ticket;
+		m_inFlightBatches.push_back(m_currentBatch);
+		m_nextTicket++;
+		beginBatch();
+
+		return ticket;
+	}
+
+	/// <summary>
+	/// Record the end of copies : visibility on a shared queue, release to the graphics queue otherwise
+	/// </summary>
+	void UploadManager::recordRelease()
+	{
+		std::vector<VkBufferMemoryBarrier>& bufferBarriers = m_currentBatch.bufferBarriers;
+		std::vector<VkImageMemoryBarrier>& imageBarriers = m_currentBatch.imageBarriers;
+
+		//Same queue : copies are made visible to next submissions
+		if (!m_separateQueue)
+		{
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = CONSUMER_ACCESS;
+
+			for (VkImageMemoryBarrier& imageBarrier : imageBarriers) {
+				imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				imageBarrier.dstAccessMask = CONSUMER_ACCESS;
+			}
+
+			vkCmdPipelineBarrier(m_currentBatch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0,
+				1, &barrier, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+			return;
+		}
+
+		//Other queue : writes are made available, the semaphore makes them visible
+		for (VkBufferMemoryBarrier& bufferBarrier : bufferBarriers) {
+			bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			bufferBarrier.dstAccessMask = 0;
+		}
+		for (VkImageMemoryBarrier& imageBarrier : imageBarriers) {
+			imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			imageBarrier.dstAccessMask = 0;
+		}
+
+		vkCmdPipelineBarrier(m_currentBatch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr, static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	}
+
+	/// <summary>
+	/// Record the graphics queue side : acquire ownership of resources written by the batch, then run the updates
+	/// </summary>
+	void UploadManager::recordAcquire()
+	{
+		VkCommandBuffer commandBuffer = m_currentBatch.acquireCommandBuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to start upload acquire command buffer recording!");
+		}
+
+		if (m_currentBatch.copyCount == 0)
+		{
+			//Updates only : nothing comes from the transfer queue
+		}
+		else if (m_ownershipTransfer)
+		{
+			//Same barriers as the release, on the destination queue
+			std::vector<VkBufferMemoryBarrier>& bufferBarriers = m_currentBatch.bufferBarriers;
+			std::vector<VkImageMemoryBarrier>& imageBarriers = m_currentBatch.imageBarriers;
+			for (VkBufferMemoryBarrier& bufferBarrier : bufferBarriers) {
+				bufferBarrier.srcAccessMask = 0;
+				bufferBarrier.dstAccessMask = CONSUMER_ACCESS;
+			}
+			for (VkImageMemoryBarrier& imageBarrier : imageBarriers) {
+				imageBarrier.srcAccessMask = 0;
+				imageBarrier.dstAccessMask = CONSUMER_ACCESS;
+			}
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, CONSUMER_STAGES, 0,
+				0, nullptr, static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+		}
+		else
+		{
+			//Same family : layouts are already final, only order later frames after the semaphore
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = CONSUMER_ACCESS;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, CONSUMER_STAGES, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+
+		recordUpdates(commandBuffer);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to end upload acquire command buffer recording");
+		}
+	}
+
+	/// <summary>
+	/// Record the in place updates of the batch on a graphics queue command buffer
+	/// </summary>
+	/// <param name="commandBuffer">Command buffer submitted to the graphics queue</param>
+	void UploadManager::recordUpdates(VkCommandBuffer commandBuffer)
+	{
+		std::vector<UploadUpdate>& updates = m_currentBatch.updates;
+		if (updates.empty())
+			return;
+
+		//Frames submitted before may still read the buffers : wait their vertex input before writing
+		//Also orders the writes after previous copies of the same ranges
+		VkMemoryBarrier hazard{};
+		hazard.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hazard.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hazard.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, CONSUMER_STAGES | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &hazard, 0, nullptr, 0, nullptr);
+
+		for (const UploadUpdate& update : updates)
+			vkCmdCopyBuffer(commandBuffer, m_stagingBuffer, update.buffer, 1, &update.region);
+
+		//Updates visible to the next frames
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = CONSUMER_ACCESS;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	/// <summary>
+	/// Start recording a new batch, recycled if possible
+	/// </summary>
+	void UploadManager::beginBatch()
+	{
+		UploadBatch batch;
+		if (!m_freeBatches.empty())
+		{
+			batch = m_freeBatches.back();
+			m_freeBatches.pop_back();
+			vkResetCommandBuffer(batch.commandBuffer, 0);
+			if (batch.acquireCommandBuffer != VK_NULL_HANDLE)
+				vkResetCommandBuffer(batch.acquireCommandBuffer, 0);
+		}
+		else
+		{
+			//Command buffer
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = m_commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(m_device, &allocInfo, &batch.commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate upload command buffer!");
+			}
+
+			//Fence, the timeline replaces it
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			if (m_timeline == nullptr && vkCreateFence(m_device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create upload fence");
+			}
+
+			//Hand over to the graphics queue
+			if (m_separateQueue)
+			{
+				allocInfo.commandPool = m_acquireCommandPool;
+				if (vkAllocateCommandBuffers(m_device, &allocInfo, &batch.acquireCommandBuffer) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to allocate upload acquire command buffer!");
+				}
+
+				VkSemaphoreCreateInfo semaphoreInfo{};
+				semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+				if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &batch.semaphore) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create upload semaphore");
+				}
+			}
+		}
+
+		batch.ticket = m_nextTicket;
+		batch.timelineValue = 0;
+		batch.ringEnd = m_ringHead;
+		batch.copyCount = 0;
+		batch.bufferBarriers.clear();
+		batch.imageBarriers.clear();
+		batch.updates.clear();
+
+		//Start recording
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(batch.commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to start upload command buffer recording!");
+		}
+
+		m_currentBatch = batch;
+	}
+
+	/// <summary>
+	/// Retire the oldest in flight batch, it must be complete
+	/// </summary>
+	void UploadManager::retireFront()
+	{
+		UploadBatch batch = m_inFlightBatches.front();
+		m_inFlightBatches.pop_front();
+
+		m_ringTail = batch.ringEnd;
+		m_completedTicket = batch.ticket;
+
+		if (batch.fence != VK_NULL_HANDLE)
+			vkResetFences(m_device, 1, &batch.fence);
+		m_freeBatches.push_back(batch);
+	}
+
+	/// <summary>
+	/// Check if a submitted batch is finished on GPU, never blocks
+	/// </summary>
+	/// <param name="batch"></param>
+	/// <returns></returns>
+	bool UploadManager::isBatchComplete(const UploadBatch& batch)
+	{
+		if (m_timeline != nullptr)
+			return m_timeline->isComplete(batch.timelineValue);
+
+		return vkGetFenceStatus(m_device, batch.fence) == VK_SUCCESS;
+	}
+
+	/// <summary>
+	/// Block until a submitted batch is finished on GPU
+	/// </summary>
+	/// <param name="batch"></param>
+	void UploadManager::waitBatch(const UploadBatch& batch)
+	{
+		if (m_timeline != nullptr)
+			m_timeline->wait(batch.timelineValue);
+		else
+			vkWaitForFences(m_device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+	}
+}
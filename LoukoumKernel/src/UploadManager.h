@@ -0,0 +1,129 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <cstring>
+#include <mutex>
+#include <functional>
+
+#include "MemoryAllocator.h"
+#include "Timeline.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Copy into a buffer the graphics queue may be reading, recorded on the graphics queue when the batch is submitted
+	/// </summary>
+	struct UploadUpdate {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkBufferCopy region{};
+	};
+
+	/// <summary>
+	/// Batch of copies recorded in one command buffer and submitted at once
+	/// </summary>
+	struct UploadBatch {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		uint64_t ticket = 0;
+		uint64_t ringEnd = 0;
+		uint32_t copyCount = 0;
+
+		//Timeline mode : value signaled on the graphics queue once the resources are usable, no fence
+		uint64_t timelineValue = 0;
+
+		//Resources written by the batch, handed over to the graphics queue on submit
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+
+		//In place updates : the graphics queue owns those buffers, no ownership transfer
+		std::vector<UploadUpdate> updates;
+	};
+
+	//Fills elements [first, first + count) at dst, dst points in the mapped staging ring
+	using UploadWriter = std::function<void(void* dst, size_t first, size_t count)>;
+
+	/// <summary>
+	/// Upload Manager : copies data to device local resources through a staging ring buffer
+	/// Copies run on the transfer queue, then resources are given to the graphics queue
+	/// Buffers the graphics queue already uses are updated on the graphics queue, they never change owner
+	/// With a timeline, batches signal the graphics timeline instead of a fence
+	/// Queues are externally synchronized : every submission holds the queue mutex shared with the frame submission
+	/// </summary>
+	class UploadManager
+	{
+	public:
+		UploadManager(VkDevice device, MemoryAllocator* allocator, uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily, VkQueue graphicsQueue, std::mutex* queueMutex, Timeline* timeline = nullptr, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+		~UploadManager();
+
+		//Uploads, return the ticket to wait for
+		uint64_t upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		uint64_t uploadWith(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize elementSize, size_t elementCount, const UploadWriter& writer);
+		uint64_t uploadImage(VkImage dstImage, uint32_t width, uint32_t height, VkImageLayout finalLayout, const void* data, VkDeviceSize size);
+
+		//Rewrite a buffer already used by the graphics queue, the copy runs on the graphics queue
+		uint64_t update(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+		//Submit recorded copies, called once per frame before the frame submission, uploads also submit when the ring is full
+		uint64_t flush();
+
+		//Completion
+		void collect();
+		bool isComplete(uint64_t ticket);
+		void wait(uint64_t ticket);
+		void waitIdle();
+
+		//Default size of the staging ring
+		static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+
+	private:
+		VkDeviceSize reserve(VkDeviceSize size, VkDeviceSize alignment);
+		uint64_t submit();
+		void recordRelease();
+		void recordAcquire();
+		void recordUpdates(VkCommandBuffer commandBuffer);
+		void beginBatch();
+		void retireFront();
+		bool isBatchComplete(const UploadBatch& batch);
+		void waitBatch(const UploadBatch& batch);
+
+		VkDevice m_device;
+		MemoryAllocator* m_allocator;
+
+		//Queues : copies on transfer queue, resources used on graphics queue
+		VkQueue m_transferQueue;
+		VkQueue m_graphicsQueue;
+		uint32_t m_transferFamily;
+		uint32_t m_graphicsFamily;
+		bool m_separateQueue;
+		bool m_ownershipTransfer;
+		VkCommandPool m_commandPool;
+		VkCommandPool m_acquireCommandPool;
+		Timeline* m_timeline;
+
+		//Shared with every other submitter of the queues, any uploading thread may submit
+		std::mutex* m_queueMutex;
+
+		//Staging ring : virtual offsets only grow, physical offset is offset % ring size
+		VkBuffer m_stagingBuffer;
+		Allocation m_stagingAllocation;
+		VkDeviceSize m_ringSize;
+		uint64_t m_ringHead;
+		uint64_t m_ringTail;
+
+		//Batches
+		UploadBatch m_currentBatch;
+		std::deque<UploadBatch> m_inFlightBatches;
+		std::vector<UploadBatch> m_freeBatches;
+		uint64_t m_nextTicket;
+		uint64_t m_completedTicket;
+
+		std::mutex m_mutex;
+	};
+}
@@ -17,3 +17,34 @@ std::vector<char> Loukoum::Utils::readFileBytecode(const std::string& filename)
 	file.close();
 	return buffer;
 }
+
+/// <summary>
+/// Mix bytes in a FNV-1a hash
+/// </summary>
+/// <param name="hash">HASH_SEED or a previous hash</param>
+/// <param name="data"></param>
+/// <param name="size">Size in bytes</param>
+/// <returns></returns>
+uint64_t Loukoum::Utils::hashBytes(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/// <summary>
+/// Mix a value in a FNV-1a hash, low byte first whatever the endianness
+/// </summary>
+/// <param name="hash">HASH_SEED or a previous hash</param>
+/// <param name="value"></param>
+/// <returns></returns>
+uint64_t Loukoum::Utils::hashValue(uint64_t hash, uint64_t value)
+{
+	uint8_t bytes[8];
+	for (int i = 0; i < 8; i++)
+		bytes[i] = (value >> (i * 8)) & 0xFF;
+	return hashBytes(hash, bytes, sizeof(bytes));
+}
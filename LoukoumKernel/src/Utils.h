@@ -3,6 +3,8 @@
 #include <vector>
 #include <fstream>
 #include <iostream>
+#include <cstdint>
+#include <cstddef>
 
 namespace Loukoum
 {
@@ -10,5 +12,10 @@ namespace Loukoum
 	{
 	public:
 		static std::vector<char> readFileBytecode(const std::string& filename);
+
+		//FNV-1a hashing, start from HASH_SEED
+		static constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+		static uint64_t hashBytes(uint64_t hash, const void* data, size_t size);
+		static uint64_t hashValue(uint64_t hash, uint64_t value);
 	};
 }
\ No newline at end of file
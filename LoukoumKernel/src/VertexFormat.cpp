@@ -0,0 +1,202 @@
+#include "VertexFormat.h"
+
+namespace Loukoum
+{
+	/// <summary>
+	/// Get size of one vertex
+	/// </summary>
+	/// <param name="format">Vertex format</param>
+	/// <returns>Vertex stride in bytes</returns>
+	uint32_t VertexFormat::getStride(int format)
+	{
+		switch (format) {
+		case VERTEX_FORMAT_FLOAT:
+			return FloatVertexLayout::STRIDE;
+		case VERTEX_FORMAT_HALF:
+			return HalfVertexLayout::STRIDE;
+		case VERTEX_FORMAT_SNORM16:
+			return Snorm16VertexLayout::STRIDE;
+		default:
+			throw std::runtime_error("Failed to find vertex format");
+		}
+	}
+
+	/// <summary>
+	/// Get binding description of a vertex format
+	/// </summary>
+	/// <param name="format">Vertex format</param>
+	/// <returns></returns>
+	VkVertexInputBindingDescription VertexFormat::getBindingDescription(int format)
+	{
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = getStride(format);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescription;
+	}
+
+	/// <summary>
+	/// Get attribute descriptions of a vertex format, from its layout
+	/// </summary>
+	/// <param name="format">Vertex format</param>
+	/// <returns></returns>
+	std::vector<VkVertexInputAttributeDescription> VertexFormat::getAttributeDescriptions(int format)
+	{
+		switch (format) {
+		case VERTEX_FORMAT_FLOAT: {
+			constexpr auto attributes = FloatVertexLayout::getAttributeDescriptions();
+			return std::vector<VkVertexInputAttributeDescription>(attributes.begin(), attributes.end());
+		}
+		case VERTEX_FORMAT_HALF: {
+			constexpr auto attributes = HalfVertexLayout::getAttributeDescriptions();
+			return std::vector<VkVertexInputAttributeDescription>(attributes.begin(), attributes.end());
+		}
+		case VERTEX_FORMAT_SNORM16: {
+			constexpr auto attributes = Snorm16VertexLayout::getAttributeDescriptions();
+			return std::vector<VkVertexInputAttributeDescription>(attributes.begin(), attributes.end());
+		}
+		default:
+			throw std::runtime_error("Failed to find vertex format");
+		}
+	}
+
+	/// <summary>
+	/// Compute dequantization bounds, positions are stored in [-1, 1] around the mesh center
+	/// </summary>
+	/// <param name="vertices">Mesh vertices</param>
+	/// <param name="format">Vertex format</param>
+	/// <returns>Identity for the float format</returns>
+	VertexBounds VertexFormat::computeBounds(const std::vector<Vertex>& vertices, int format)
+	{
+		VertexBounds bounds;
+		if (format == VERTEX_FORMAT_FLOAT || vertices.empty())
+			return bounds;
+
+		glm::vec3 minPos = vertices[0].pos;
+		glm::vec3 maxPos = vertices[0].pos;
+		for (const Vertex& vertex : vertices) {
+			minPos = glm::min(minPos, vertex.pos);
+			maxPos = glm::max(maxPos, vertex.pos);
+		}
+
+		//Flat axis keep a non null scale
+		glm::vec3 halfExtent = glm::max((maxPos - minPos) * 0.5f, glm::vec3(1e-6f));
+		bounds.offset = glm::vec4((minPos + maxPos) * 0.5f, 0.0f);
+		bounds.scale = glm::vec4(halfExtent, 1.0f);
+		return bounds;
+	}
+
+	/// <summary>
+	/// Compute smooth normals from triangles, weighted by triangle area
+	/// Normals are not normalized : triangles can be added or removed later, packVertex normalizes
+	/// </summary>
+	/// <param name="vertices">Mesh vertices</param>
+	/// <param name="indices">Triangle list indices</param>
+	/// <returns>One normal per vertex</returns>
+	std::vector<glm::vec3> VertexFormat::computeNormals(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.0f));
+
+		//Unnormalized cross product length is twice the triangle area
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			const glm::vec3& p0 = vertices[indices[i]].pos;
+			const glm::vec3& p1 = vertices[indices[i + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[i + 2]].pos;
+			glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+			normals[indices[i]] += faceNormal;
+			normals[indices[i + 1]] += faceNormal;
+			normals[indices[i + 2]] += faceNormal;
+		}
+
+		return normals;
+	}
+
+	/// <summary>
+	/// Pack vertices in a compressed format
+	/// </summary>
+	/// <param name="vertices">Mesh vertices</param>
+	/// <param name="indices">Triangle list indices, used to compute normals</param>
+	/// <param name="format">VERTEX_FORMAT_HALF or VERTEX_FORMAT_SNORM16</param>
+	/// <param name="bounds">Bounds from computeBounds</param>
+	/// <returns></returns>
+	std::vector<PackedVertex> VertexFormat::pack(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, int format, const VertexBounds& bounds)
+	{
+		std::vector<glm::vec3> normals = computeNormals(vertices, indices);
+
+		std::vector<PackedVertex> packed(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+			packed[i] = packVertex(vertices[i], normals[i], format, bounds);
+
+		return packed;
+	}
+
+	/// <summary>
+	/// Pack one vertex in a compressed format
+	/// </summary>
+	/// <param name="vertex">Vertex, position is clamped to the bounds</param>
+	/// <param name="normal">Normal, any length</param>
+	/// <param name="format">VERTEX_FORMAT_HALF or VERTEX_FORMAT_SNORM16</param>
+	/// <param name="bounds">Bounds from computeBounds</param>
+	/// <returns></returns>
+	PackedVertex VertexFormat::packVertex(const Vertex& vertex, glm::vec3 normal, int format, const VertexBounds& bounds)
+	{
+		if (format != VERTEX_FORMAT_HALF && format != VERTEX_FORMAT_SNORM16)
+			throw std::runtime_error("Failed to pack vertex : format is not compressed");
+
+		//Position in [-1, 1]
+		glm::vec3 pos = glm::clamp((vertex.pos - glm::vec3(bounds.offset)) / glm::vec3(bounds.scale), glm::vec3(-1.0f), glm::vec3(1.0f));
+
+		//Normal : vertices without triangle face the camera
+		float length = glm::length(normal);
+		glm::vec2 encoded = encodeOctahedral(length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f));
+
+		if (format == VERTEX_FORMAT_HALF)
+			return HalfVertexLayout::pack(glm::vec4(pos, 0.0f), vertex.color, encoded);
+		return Snorm16VertexLayout::pack(glm::vec4(pos, 0.0f), vertex.color, encoded);
+	}
+
+	/// <summary>
+	/// Check if a position can be packed without clamping
+	/// </summary>
+	/// <param name="pos"></param>
+	/// <param name="bounds"></param>
+	/// <returns></returns>
+	bool VertexFormat::isInBounds(glm::vec3 pos, const VertexBounds& bounds)
+	{
+		glm::vec3 distance = glm::abs(pos - glm::vec3(bounds.offset));
+		return distance.x <= bounds.scale.x && distance.y <= bounds.scale.y && distance.z <= bounds.scale.z;
+	}
+
+	/// <summary>
+	/// Encode a unit normal on the octahedron unfolded in [-1, 1]^2
+	/// </summary>
+	/// <param name="normal">Unit normal</param>
+	/// <returns></returns>
+	glm::vec2 VertexFormat::encodeOctahedral(glm::vec3 normal)
+	{
+		normal /= (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+		glm::vec2 encoded = glm::vec2(normal.x, normal.y);
+
+		//Lower hemisphere folded over the diagonals
+		if (normal.z < 0.0f) {
+			glm::vec2 signs = glm::vec2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+			encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+		}
+
+		return encoded;
+	}
+
+	/// <summary>
+	/// Decode an octahedral normal, same code as the vertex shader
+	/// </summary>
+	/// <param name="encoded">Encoded normal in [-1, 1]^2</param>
+	/// <returns>Unit normal</returns>
+	glm::vec3 VertexFormat::decodeOctahedral(glm::vec2 encoded)
+	{
+		glm::vec3 normal = glm::vec3(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+		float t = glm::max(-normal.z, 0.0f);
+		normal.x += normal.x >= 0.0f ? -t : t;
+		normal.y += normal.y >= 0.0f ? -t : t;
+		return glm::normalize(normal);
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <functional>
+#include <type_traits>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "VertexLayout.h"
+
+namespace Loukoum
+{
+	//Vertex formats : how vertices are stored in the vertex buffer
+	constexpr int VERTEX_FORMAT_FLOAT = 0;		//28 bytes : float position, float color
+	constexpr int VERTEX_FORMAT_HALF = 1;		//16 bytes : half position, RGBA8 color, octahedral normal
+	constexpr int VERTEX_FORMAT_SNORM16 = 2;	//16 bytes : snorm16 position, RGBA8 color, octahedral normal
+
+	/// <summary>
+	/// Vertex structure
+	/// </summary>
+	struct Vertex {
+		glm::vec3 pos;
+		glm::vec4 color;
+
+		bool operator==(const Vertex& other) const {
+			return pos == other.pos && color == other.color;
+		}
+	};
+
+	/// <summary>
+	/// Vertex hash : used to weld identical vertices
+	/// </summary>
+	struct VertexHash {
+		size_t operator()(const Vertex& vertex) const {
+			std::hash<float> hasher;
+			size_t seed = 0;
+			const float values[] = { vertex.pos.x, vertex.pos.y, vertex.pos.z, vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a };
+			for (float value : values)
+				seed ^= hasher(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+			return seed;
+		}
+	};
+
+	/// <summary>
+	/// Compressed vertex used by the half and snorm16 formats
+	/// </summary>
+	struct PackedVertex {
+		uint16_t pos[4];	//xyz quantized in bounds, w unused
+		uint32_t color;		//RGBA8 unorm
+		int16_t normal[2];	//Octahedral snorm16
+	};
+	static_assert(sizeof(PackedVertex) == 16, "PackedVertex must be 16 bytes");
+
+	//Buffer layouts of the vertex formats, locations : 0 position, 1 color, 2 normal
+	using FloatVertexLayout = VertexLayout<Vertex,
+		VertexAttribute<0, VK_FORMAT_R32G32B32_SFLOAT>,
+		VertexAttribute<1, VK_FORMAT_R32G32B32A32_SFLOAT>>;
+	using HalfVertexLayout = VertexLayout<PackedVertex,
+		VertexAttribute<0, VK_FORMAT_R16G16B16A16_SFLOAT>,
+		VertexAttribute<1, VK_FORMAT_R8G8B8A8_UNORM>,
+		VertexAttribute<2, VK_FORMAT_R16G16_SNORM>>;
+	using Snorm16VertexLayout = VertexLayout<PackedVertex,
+		VertexAttribute<0, VK_FORMAT_R16G16B16A16_SNORM>,
+		VertexAttribute<1, VK_FORMAT_R8G8B8A8_UNORM>,
+		VertexAttribute<2, VK_FORMAT_R16G16_SNORM>>;
+
+	//Members of the vertex structs at the offsets of their layout
+	static_assert(FloatVertexLayout::OFFSETS[0] == offsetof(Vertex, pos) && FloatVertexLayout::OFFSETS[1] == offsetof(Vertex, color), "Float layout must match Vertex");
+	static_assert(HalfVertexLayout::OFFSETS[0] == offsetof(PackedVertex, pos) && HalfVertexLayout::OFFSETS[1] == offsetof(PackedVertex, color) && HalfVertexLayout::OFFSETS[2] == offsetof(PackedVertex, normal), "Half layout must match PackedVertex");
+	static_assert(Snorm16VertexLayout::OFFSETS[0] == offsetof(PackedVertex, pos) && Snorm16VertexLayout::OFFSETS[1] == offsetof(PackedVertex, color) && Snorm16VertexLayout::OFFSETS[2] == offsetof(PackedVertex, normal), "Snorm16 layout must match PackedVertex");
+
+	/// <summary>
+	/// Per mesh dequantization : position = offset + scale * stored position
+	/// Given to the vertex shader as push constant
+	/// </summary>
+	struct VertexBounds {
+		glm::vec4 offset = glm::vec4(0.0f);
+		glm::vec4 scale = glm::vec4(1.0f);
+	};
+
+	/// <summary>
+	/// Vertex Format : Vulkan descriptions and CPU packers of every vertex format
+	/// The only place buffer layouts are described, pipelines keep the attributes their vertex shader reads
+	/// </summary>
+	class VertexFormat
+	{
+	public:
+		//Vulkan descriptions
+		static uint32_t getStride(int format);
+		static VkVertexInputBindingDescription getBindingDescription(int format);
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(int format);
+
+		//Packing
+		static VertexBounds computeBounds(const std::vector<Vertex>& vertices, int format);
+		static std::vector<glm::vec3> computeNormals(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		static std::vector<PackedVertex> pack(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, int format, const VertexBounds& bounds);
+		static PackedVertex packVertex(const Vertex& vertex, glm::vec3 normal, int format, const VertexBounds& bounds);
+		static bool isInBounds(glm::vec3 pos, const VertexBounds& bounds);
+
+		//Octahedral normals
+		static glm::vec2 encodeOctahedral(glm::vec3 normal);
+		static glm::vec3 decodeOctahedral(glm::vec2 encoded);
+	};
+}
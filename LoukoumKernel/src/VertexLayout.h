@@ -0,0 +1,190 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace Loukoum
+{
+	/// <summary>
+	/// CPU side of a Vulkan attribute format : value written by the application, type stored in the vertex buffer
+	/// Only the formats used by vertex layouts are defined, another format does not compile
+	/// </summary>
+	template<VkFormat Format>
+	struct VertexFormatTraits;
+
+	template<>
+	struct VertexFormatTraits<VK_FORMAT_R32G32_SFLOAT> {
+		using Value = glm::vec2;
+		using Type = glm::vec2;
+		static Type pack(const Value& value) { return value; }
+	};
+
+	template<>
+	struct VertexFormatTraits<VK_FORMAT_R32G32B32_SFLOAT> {
+		using Value = glm::vec3;
+		using Type = glm::vec3;
+		static Type pack(const Value& value) { return value; }
+	};
+
+	template<>
+	struct VertexFormatTraits<VK_FORMAT_R32G32B32A32_SFLOAT> {
+		using Value = glm::vec4;
+		using Type = glm::vec4;
+		static Type pack(const Value& value) { return value; }
+	};
+
+	template<>
+	struct VertexFormatTraits<VK_FORMAT_R16G16B16A16_SFLOAT> {
+		using Value = glm::vec4;
+		using Type = std::array<uint16_t, 4>;
+		static Type pack(const Value& value) {
+			return { glm::packHalf1x16(value.x), glm::packHalf1x16(value.y), glm::packHalf1x16(value.z), glm::packHalf1x16(value.w) };
+		}
+	};
+
+	template<>
+	struct VertexFormatTraits<VK_FORMAT_R16G16B16A16_SNORM> {
+		using Value = glm::vec4;
+		using Type = std::array<uint16_t, 4>;
+		static Type pack(const Value& value) {
+			return { glm::packSnorm1x16(value.x), glm::packSnorm1x16(value.y), glm::packSnorm1x16(value.z), glm::packSnorm1x16(value.w) };
+		}
+	};
+
+	template<>
+	struct VertexFormatTraits<VK_FORMAT_R16G16_SNORM> {
+		using Value = glm::vec2;
+		using Type = std::array<uint16_t, 2>;
+		static Type pack(const Value& value) {
+			return { glm::packSnorm1x16(value.x), glm::packSnorm1x16(value.y) };
+		}
+	};
+
+	template<>
+	struct VertexFormatTraits<VK_FORMAT_R8G8B8A8_UNORM> {
+		using Value = glm::vec4;
+		using Type = uint32_t;
+		static Type pack(const Value& value) { return glm::packUnorm4x8(value); }
+	};
+
+	/// <summary>
+	/// Attribute of a vertex layout : shader location and Vulkan format
+	/// </summary>
+	template<uint32_t Location, VkFormat Format>
+	struct VertexAttribute {
+		static constexpr uint32_t LOCATION = Location;
+		static constexpr VkFormat FORMAT = Format;
+		using Traits = VertexFormatTraits<Format>;
+		using Value = typename Traits::Value;
+		using Type = typename Traits::Type;
+	};
+
+	/// <summary>
+	/// Offset of each stored type, aligned like the members of a struct
+	/// </summary>
+	/// <returns></returns>
+	template<typename... Types>
+	constexpr std::array<uint32_t, sizeof...(Types)> getVertexOffsets()
+	{
+		constexpr uint32_t sizes[] = { static_cast<uint32_t>(sizeof(Types))... };
+		constexpr uint32_t alignments[] = { static_cast<uint32_t>(alignof(Types))... };
+
+		std::array<uint32_t, sizeof...(Types)> offsets{};
+		uint32_t offset = 0;
+		for (size_t i = 0; i < sizeof...(Types); i++) {
+			offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+			offsets[i] = offset;
+			offset += sizes[i];
+		}
+		return offsets;
+	}
+
+	/// <summary>
+	/// Size of the stored types with padding, a multiple of the largest alignment like sizeof of a struct
+	/// </summary>
+	/// <returns></returns>
+	template<typename... Types>
+	constexpr uint32_t getVertexStride()
+	{
+		constexpr uint32_t sizes[] = { static_cast<uint32_t>(sizeof(Types))... };
+		constexpr uint32_t alignment = std::max({ static_cast<uint32_t>(alignof(Types))... });
+		constexpr std::array<uint32_t, sizeof...(Types)> offsets = getVertexOffsets<Types...>();
+
+		uint32_t end = offsets[sizeof...(Types) - 1] + sizes[sizeof...(Types) - 1];
+		return (end + alignment - 1) / alignment * alignment;
+	}
+
+	/// <summary>
+	/// Vertex Layout : attributes of a vertex struct declared once, in buffer order
+	/// Offsets, stride and Vulkan descriptions are computed at compile time, packing writes each attribute in place
+	/// Attributes are aligned on their stored type, like the members of a struct : the struct must have the same size and alignment
+	/// Offsets of the members are checked next to the struct, with offsetof against OFFSETS
+	/// </summary>
+	template<typename VertexType, typename... Attributes>
+	class VertexLayout
+	{
+	public:
+		static_assert(sizeof...(Attributes) > 0, "A vertex layout needs attributes");
+
+		static constexpr size_t ATTRIBUTE_COUNT = sizeof...(Attributes);
+		static constexpr uint32_t ALIGNMENT = std::max({ static_cast<uint32_t>(alignof(typename Attributes::Type))... });
+		static constexpr std::array<uint32_t, ATTRIBUTE_COUNT> OFFSETS = getVertexOffsets<typename Attributes::Type...>();
+		static constexpr uint32_t STRIDE = getVertexStride<typename Attributes::Type...>();
+
+		//Vertex as stored in the vertex buffer
+		using Vertex = VertexType;
+		static_assert(std::is_trivially_copyable<Vertex>::value, "Vertex of a layout must be uploaded as bytes");
+		static_assert(sizeof(Vertex) == STRIDE, "Vertex size must match the layout stride");
+		static_assert(alignof(Vertex) == ALIGNMENT, "Vertex alignment must match the layout");
+
+		/// <summary>
+		/// Get attribute descriptions, in declaration order
+		/// </summary>
+		/// <param name="binding">Vertex buffer binding</param>
+		/// <returns></returns>
+		static constexpr std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> getAttributeDescriptions(uint32_t binding = 0)
+		{
+			return makeAttributeDescriptions(binding, std::index_sequence_for<Attributes...>{});
+		}
+
+		/// <summary>
+		/// Pack one vertex, one value per attribute in declaration order
+		/// </summary>
+		/// <param name="values"></param>
+		/// <returns></returns>
+		static Vertex pack(const typename Attributes::Value&... values)
+		{
+			Vertex vertex{};
+			packAttributes(vertex, std::index_sequence_for<Attributes...>{}, values...);
+			return vertex;
+		}
+
+	private:
+		template<size_t... Indices>
+		static constexpr std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> makeAttributeDescriptions(uint32_t binding, std::index_sequence<Indices...>)
+		{
+			return { { VkVertexInputAttributeDescription{ Attributes::LOCATION, binding, Attributes::FORMAT, OFFSETS[Indices] }... } };
+		}
+
+		template<size_t... Indices>
+		static void packAttributes(Vertex& vertex, std::index_sequence<Indices...>, const typename Attributes::Value&... values)
+		{
+			(writeAttribute(vertex, OFFSETS[Indices], Attributes::Traits::pack(values)), ...);
+		}
+
+		template<typename T>
+		static void writeAttribute(Vertex& vertex, uint32_t offset, const T& packed)
+		{
+			std::memcpy(reinterpret_cast<uint8_t*>(&vertex) + offset, &packed, sizeof(T));
+		}
+	};
+}
@@ -5,17 +5,37 @@ namespace Loukoum
 	/// <summary>
 	/// Constructor : init VkInstance
 	/// </summary>
-	Vulkan::Vulkan(GLFWwindow* window)
+	/// <param name="window"></param>
+	/// <param name="timelineSemaphores">Synchronize with a timeline semaphore when Vulkan 1.2 is available, fences otherwise</param>
+	Vulkan::Vulkan(GLFWwindow* window, bool timelineSemaphores)
 	{
 		m_window = window;
+		m_timelineRequested = timelineSemaphores;
 		//m_shaders = std::vector<Shader*>();
-		m_shaderModules = std::vector<VkShaderModule>();
 		m_vertices = std::vector<Vertex>();
 
 		createInstance();
 		pickPhysicalDevice();
 		createLogicalDevice();
-		createCommandPool();
+		if (m_timelineSupported)
+			m_timeline = new Timeline(m_logicalDevice);
+		m_allocator = new MemoryAllocator(m_physicalDevice, m_logicalDevice, m_memoryBudgetSupported);
+		m_deletionQueue = new DeletionQueue(m_logicalDevice, m_allocator, m_timeline);
+		QueueFamilyIndices indices = findQueueFamilies(m_physicalDevice);
+		m_uploadManager = new UploadManager(m_logicalDevice, m_allocator, indices.transferFamily.value(), m_transferQueue, indices.graphicsFamily.value(), m_graphicsQueue, &m_queueMutex, m_timeline);
+		m_allocator->setEvictionCallback([this](uint32_t heapIndex, VkDeviceSize, int priority) { return evictStaticMesh(heapIndex, priority); });
+		m_threadPool = new ThreadPool();
+		m_pipelineCache = new PipelineCache(m_physicalDevice, m_logicalDevice);
+		m_shaderLibrary = new ShaderLibrary(m_logicalDevice, m_deletionQueue);
+		m_layoutCache = new PipelineLayoutCache(m_logicalDevice);
+		m_shaderCompiler = new ShaderCompiler();
+		m_pipelineManager = new PipelineManager(m_logicalDevice, m_pipelineCache, m_shaderLibrary, m_layoutCache, m_deletionQueue);
+		if (m_pipelineLibrarySupported)
+			m_pipelineManager->enablePipelineLibrary();
+		if (m_shaderObjectSupported)
+			m_pipelineManager->enableShaderObjects();
+		m_pipelineManifest = new PipelineManifest();
+		createCommandPools();
 		recreateSwapChain();
 		createSyncObjects();
 	}
@@ -25,19 +45,45 @@ namespace Loukoum
 	/// </summary>
 	Vulkan::~Vulkan()
 	{
+		//Only wait on shutdown, at runtime resources go through the deletion queue
 		vkDeviceWaitIdle(m_logicalDevice);
 		cleanUpSwapChain();
-
-		vkDestroyBuffer(m_logicalDevice, m_vertexBuffer, nullptr);
-		vkFreeMemory(m_logicalDevice, m_vertexBufferMemory, nullptr);
+		cleanUpPipeline();
+		delete m_pipelineManifest;
+		m_pipelineManager->printStats();
+		delete m_pipelineManager;
+		m_layoutCache->printStats();
+		delete m_layoutCache;
+		delete m_shaderCompiler;
+		m_shaderLibrary->printStats();
+		if (m_vertexShader != 0)
+			m_shaderLibrary->release(m_vertexShader);
+		if (m_fragmentShader != 0)
+			m_shaderLibrary->release(m_fragmentShader);
+		delete m_shaderLibrary;
+
+		delete m_uploadManager;
+
+		delete m_vertexBuffer;
+		delete m_indexBuffer;
+		for (StaticMesh& mesh : m_staticMeshes) {
+			m_allocator->destroyBuffer(mesh.vertexBuffer, mesh.vertexAllocation);
+			m_allocator->destroyBuffer(mesh.indexBuffer, mesh.indexAllocation);
+		}
+		delete m_deletionQueue;
 
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 			vkDestroySemaphore(m_logicalDevice, m_renderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(m_logicalDevice, m_imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(m_logicalDevice, m_inFlightFences[i], nullptr);
 		}
-		vkDestroyCommandPool(m_logicalDevice, m_commandPool, nullptr);
-
+		for (VkFence fence : m_inFlightFences)
+			vkDestroyFence(m_logicalDevice, fence, nullptr);
+		delete m_timeline;
+		delete m_pipelineCache;
+		destroyCommandPools();
+		delete m_threadPool;
+
+		delete m_allocator;
 		vkDestroyDevice(m_logicalDevice, nullptr);
 		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
 		vkDestroyInstance(m_instance, nullptr);
@@ -58,13 +104,54 @@ namespace Loukoum
 		std::cout << std::endl;
 	}
 
+	/// <summary>
+	/// Print GPU memory usage in the console
+	/// </summary>
+	void Vulkan::printMemoryStats()
+	{
+		m_allocator->printStats();
+	}
+
 	/// <summary>
 	/// Draw Frame
 	/// </summary>
 	void Vulkan::drawFrame()
 	{
-		//Wait all fences
-		vkWaitForFences(m_logicalDevice, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+		//New frame pacing policy
+		if (m_framePacingChanged)
+			applyFramePacing();
+		auto frameStart = std::chrono::steady_clock::now();
+
+		//Wait the last frame recorded in this frame's command buffers
+		if (m_timeline != nullptr)
+			m_timeline->wait(m_frameTimelineValues[m_currentFrame]);
+		else
+			vkWaitForFences(m_logicalDevice, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+
+		measureFrameLatency();
+
+		//Budgets change with other applications
+		m_allocator->updateBudget();
+		m_pipelineCache->update();
+
+		//Shaders recompiled since last frame, frames in flight keep the old pipeline
+		reloadShaders();
+
+		//Resources released by finished work : the timeline gives the exact value reached
+		if (m_timeline != nullptr) {
+			m_deletionQueue->collect(m_timeline->getCompletedValue());
+		}
+		else {
+			//The fence of the current frame is signaled : every frame up to m_frameNumber - framesInFlight is done
+			uint64_t framesInFlight = m_framePacing.framesInFlight;
+			uint64_t completedFrames = m_frameNumber + 1 >= framesInFlight ? m_frameNumber + 1 - framesInFlight : 0;
+			m_deletionQueue->collect(completedFrames);
+		}
+
+		//Submit uploads recorded since last frame, they run before this frame on the queue
+		updateGeometry();
+		m_uploadManager->collect();
+		m_uploadManager->flush();
 
 		//Get image index from swapchain
 		uint32_t imageIndex;
@@ -80,11 +167,19 @@ namespace Loukoum
 		}
 
 		//If frame still in use, wait
-		if (m_imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-			vkWaitForFences(m_logicalDevice, 1, &m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+		if (m_timeline != nullptr) {
+			m_timeline->wait(m_imageTimelineValues[imageIndex]);
+		}
+		else {
+			if (m_imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+				vkWaitForFences(m_logicalDevice, 1, &m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+			}
+			//The new current frame is now in use
+			m_imagesInFlight[imageIndex] = m_inFlightFences[m_currentFrame];
 		}
-		//The new current frame is now in use
-		m_imagesInFlight[imageIndex] = m_inFlightFences[m_currentFrame];
+
+		//Scene recorded for this frame
+		recordFrame(imageIndex);
 
 		//Prepare a command to get image
 		VkSubmitInfo submitInfo{};
@@ -96,18 +191,34 @@ namespace Loukoum
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_commandBuffers[imageIndex];
+		submitInfo.pCommandBuffers = &m_frameCommands[m_currentFrame].primary;
 
 		//Link render finished semaphore
 		VkSemaphore signalSemaphores[] = { m_renderFinishedSemaphores[m_currentFrame] };
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
-		//Submit command
-		vkResetFences(m_logicalDevice, 1, &m_inFlightFences[m_currentFrame]);
-		if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to send a Command Buffer");
+		//Submit command : the timeline value replaces the fence
+		if (m_timeline != nullptr) {
+			std::lock_guard<std::mutex> queueLock(m_queueMutex);
+			uint64_t value = m_timeline->submit(m_graphicsQueue, submitInfo);
+			m_frameTimelineValues[m_currentFrame] = value;
+			m_imageTimelineValues[imageIndex] = value;
 		}
+		else {
+			vkResetFences(m_logicalDevice, 1, &m_inFlightFences[m_currentFrame]);
+			std::lock_guard<std::mutex> queueLock(m_queueMutex);
+			if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to send a Command Buffer");
+			}
+		}
+		m_frameNumber++;
+		m_deletionQueue->setFrameNumber(m_frameNumber);
+
+		//Frame measured once the GPU is done with it
+		m_frameStartTimes[m_currentFrame] = frameStart;
+		m_frameMeasured[m_currentFrame] = false;
+		m_framePacingStats.frameCount++;
 
 		//Presentation Image info
 		VkPresentInfoKHR presentInfo{};
@@ -123,7 +234,10 @@ namespace Loukoum
 		presentInfo.pResults = nullptr;
 
 		//Show image
-		result = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+		{
+			std::lock_guard<std::mutex> queueLock(m_queueMutex);
+			result = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+		}
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_framebufferResized) {
 			m_framebufferResized = false;
 			recreateSwapChain();
@@ -133,62 +247,605 @@ namespace Loukoum
 		}
 
 		//Next frame
-		m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		m_currentFrame = (m_currentFrame + 1) % m_framePacing.framesInFlight;
 	}
 
 	/// <summary>
-	/// Create Vertex Buffer
+	/// Create Vertex Buffer and its Index Buffer
+	/// Geometry added later is uploaded incrementally
 	/// </summary>
 	void Vulkan::createVertexBuffer()
 	{
-		//Buffer info
-		VkBufferCreateInfo bufferInfo{};
-		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferInfo.size = sizeof(Vertex) * m_vertices.size();
-		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (m_vertexBuffer != nullptr)
+			throw std::runtime_error("Failed to create vertex buffer : already created");
+
+		optimizeGeometry();
+
+		//Create growable buffers in device local memory
+		VkDeviceSize stride = VertexFormat::getStride(m_vertexFormat);
+		m_indexType = m_vertices.size() <= 0x10000 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		VkDeviceSize indexSize = m_indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		m_vertexBuffer = new GeometryBuffer(m_allocator, m_uploadManager, m_deletionQueue, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, MEMORY_CATEGORY_VERTEX, stride * m_vertices.size());
+		m_indexBuffer = new GeometryBuffer(m_allocator, m_uploadManager, m_deletionQueue, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, MEMORY_CATEGORY_INDEX, indexSize * m_indices.size());
+
+		//Compressed formats : per mesh bounds and normals kept to pack later vertices
+		m_vertexBounds = VertexFormat::computeBounds(m_vertices, m_vertexFormat);
+		if (m_vertexFormat != VERTEX_FORMAT_FLOAT)
+			m_vertexNormals = VertexFormat::computeNormals(m_vertices, m_indices);
+
+		//Copied through the staging ring with the next frame
+		writeVertices(0, m_vertices.size());
+		writeIndices(0, m_indices.size());
+
+		std::cout << "Geometry : " << m_vertices.size() << " unique vertices, " << m_indices.size() << " indices, " << m_vertexBuffer->getSize() << " vertex bytes" << std::endl;
+	}
+
+	/// <summary>
+	/// Reorder triangles and vertices for the vertex cache, overdraw and vertex fetch, then print the gain
+	/// </summary>
+	void Vulkan::optimizeGeometry()
+	{
+		if (m_indices.empty())
+			return;
 
-		//Create Buffer
-		if (vkCreateBuffer(m_logicalDevice, &bufferInfo, nullptr, &m_vertexBuffer) != VK_SUCCESS) {
-			throw std::runtime_error("(Vertex Class) Failed to create vertex buffer!");
+		VertexCacheStats before = MeshOptimizer::analyzeVertexCache(m_indices, m_vertices.size());
+
+		MeshOptimizer::optimizeVertexCache(m_indices, m_vertices.size());
+		MeshOptimizer::optimizeOverdraw(m_indices, m_vertices);
+		MeshOptimizer::optimizeVertexFetch(m_vertices, m_indices);
+
+		//Welded vertices moved : lookup is rebuilt on next weld
+		m_vertexLookup.clear();
+		m_vertexLookupSize = 0;
+
+		VertexCacheStats after = MeshOptimizer::analyzeVertexCache(m_indices, m_vertices.size());
+
+		std::cout << "Mesh optimization : ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+	}
+
+	/// <summary>
+	/// Upload geometry edited since last frame, called before the upload manager flush
+	/// </summary>
+	void Vulkan::updateGeometry()
+	{
+		if (m_vertexBuffer == nullptr)
+			return;
+
+		if (m_repackVertices)
+			repackVertices();
+
+		//Buffers replaced by a growth go to the deletion queue, frames are recorded again each frame
+		m_vertexBuffer->flush();
+		m_indexBuffer->flush();
+	}
+
+	/// <summary>
+	/// Pack vertices in the vertex buffer format and write them to the vertex buffer
+	/// </summary>
+	/// <param name="first">First vertex</param>
+	/// <param name="count">Number of vertices</param>
+	void Vulkan::writeVertices(size_t first, size_t count)
+	{
+		if (count == 0)
+			return;
+
+		VkDeviceSize stride = VertexFormat::getStride(m_vertexFormat);
+
+		//Float format : same layout as CPU vertices
+		if (m_vertexFormat == VERTEX_FORMAT_FLOAT) {
+			m_vertexBuffer->write(first * stride, &m_vertices[first], count * stride);
+			return;
 		}
 
-		//Memory requirements
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(m_logicalDevice, m_vertexBuffer, &memRequirements);
+		//Compressed formats : vertices out of the bounds need new bounds and a full repack
+		for (size_t i = first; i < first + count && !m_repackVertices; i++) {
+			if (!VertexFormat::isInBounds(m_vertices[i].pos, m_vertexBounds)) {
+				m_repackVertices = true;
+				break;
+			}
+			PackedVertex packed = VertexFormat::packVertex(m_vertices[i], m_vertexNormals[i], m_vertexFormat, m_vertexBounds);
+			m_vertexBuffer->write(i * stride, &packed, stride);
+		}
+	}
 
-		///Memory allocation info
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	/// <summary>
+	/// Compute new bounds with some margin and pack all vertices again
+	/// </summary>
+	void Vulkan::repackVertices()
+	{
+		m_vertexBounds = VertexFormat::computeBounds(m_vertices, m_vertexFormat);
+		m_vertexBounds.scale = glm::vec4(glm::vec3(m_vertexBounds.scale) * 1.25f, 1.0f);
+
+		std::vector<PackedVertex> packed(m_vertices.size());
+		for (size_t i = 0; i < m_vertices.size(); i++)
+			packed[i] = VertexFormat::packVertex(m_vertices[i], m_vertexNormals[i], m_vertexFormat, m_vertexBounds);
+		m_vertexBuffer->write(0, packed.data(), packed.size() * sizeof(PackedVertex));
+		m_repackVertices = false;
+	}
 
-		//Allocation
-		if (vkAllocateMemory(m_logicalDevice, &allocInfo, nullptr, &m_vertexBufferMemory) != VK_SUCCESS) {
-			throw std::runtime_error("(Vertex Class) Failed to allocate vertex buffer memory!");
+	/// <summary>
+	/// Write indices to the index buffer, switch to 32 bits indices when vertices don't fit 16 bits anymore
+	/// </summary>
+	/// <param name="first">First index</param>
+	/// <param name="count">Number of indices</param>
+	void Vulkan::writeIndices(size_t first, size_t count)
+	{
+		if (m_indexType == VK_INDEX_TYPE_UINT16 && m_vertices.size() > 0x10000) {
+			m_indexType = VK_INDEX_TYPE_UINT32;
+			first = 0;
+			count = m_indices.size();
 		}
 
-		//Bind Buffer with memory
-		vkBindBufferMemory(m_logicalDevice, m_vertexBuffer, m_vertexBufferMemory, 0);
+		if (count == 0)
+			return;
 
-		void* data;
-		vkMapMemory(m_logicalDevice, m_vertexBufferMemory, 0, bufferInfo.size, 0, &data);
-		memcpy(data, m_vertices.data(), (size_t)bufferInfo.size);
-		vkUnmapMemory(m_logicalDevice, m_vertexBufferMemory);
+		if (m_indexType == VK_INDEX_TYPE_UINT16) {
+			//Narrow indices
+			std::vector<uint16_t> indices16(m_indices.begin() + first, m_indices.begin() + first + count);
+			m_indexBuffer->write(first * sizeof(uint16_t), indices16.data(), count * sizeof(uint16_t));
+		}
+		else {
+			//Wide indices
+			m_indexBuffer->write(first * sizeof(uint32_t), &m_indices[first], count * sizeof(uint32_t));
+		}
 	}
 
 	/// <summary>
-	/// Add vertex
+	/// Indices appended : update normals of completed triangles and write indices
+	/// </summary>
+	/// <param name="first">First new index</param>
+	void Vulkan::writeNewIndices(size_t first)
+	{
+		if (m_vertexBuffer == nullptr)
+			return;
+
+		if (m_vertexFormat != VERTEX_FORMAT_FLOAT) {
+			for (size_t triangle = first / 3; triangle < m_indices.size() / 3; triangle++)
+				addTriangleNormal(triangle, 1.0f);
+		}
+
+		writeIndices(first, m_indices.size() - first);
+	}
+
+	/// <summary>
+	/// Add or remove the face normal of a triangle to its vertices normals, and write these vertices
+	/// </summary>
+	/// <param name="triangle">Triangle index</param>
+	/// <param name="sign">1 to add, -1 to remove</param>
+	void Vulkan::addTriangleNormal(size_t triangle, float sign)
+	{
+		const uint32_t* corners = &m_indices[triangle * 3];
+		glm::vec3 faceNormal = glm::cross(m_vertices[corners[1]].pos - m_vertices[corners[0]].pos, m_vertices[corners[2]].pos - m_vertices[corners[0]].pos);
+		for (int c = 0; c < 3; c++) {
+			m_vertexNormals[corners[c]] += sign * faceNormal;
+			writeVertices(corners[c], 1);
+		}
+	}
+
+	/// <summary>
+	/// Add vertex, three consecutive vertices make a triangle
 	/// </summary>
 	/// <param name="pos"></param>
 	/// <param name="color"></param>
 	void Vulkan::addVertex(glm::vec3 pos, glm::vec4 color)
 	{
-		m_vertices.push_back({ pos, color });
+		size_t first = m_indices.size();
+		m_indices.push_back(weldVertex({ pos, color }));
+		writeNewIndices(first);
 	}
 
 	/// <summary>
-	/// Recreate Swapchain
+	/// Add triangle
+	/// </summary>
+	/// <param name="v0"></param>
+	/// <param name="v1"></param>
+	/// <param name="v2"></param>
+	void Vulkan::addTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+	{
+		size_t first = m_indices.size();
+		m_indices.push_back(weldVertex(v0));
+		m_indices.push_back(weldVertex(v1));
+		m_indices.push_back(weldVertex(v2));
+		writeNewIndices(first);
+	}
+
+	/// <summary>
+	/// Add indexed mesh, its vertices are welded with the ones already added
+	/// </summary>
+	/// <param name="vertices">Mesh vertices</param>
+	/// <param name="indices">Triangle list indices into mesh vertices</param>
+	void Vulkan::addMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		if (indices.size() % 3 != 0)
+			throw std::runtime_error("Failed to add mesh : index count is not a multiple of 3");
+
+		//Remap mesh vertices once, then translate indices
+		std::vector<uint32_t> remap(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+			remap[i] = weldVertex(vertices[i]);
+
+		size_t first = m_indices.size();
+		m_indices.reserve(m_indices.size() + indices.size());
+		for (uint32_t index : indices) {
+			if (index >= vertices.size()) {
+				m_indices.resize(first);
+				throw std::runtime_error("Failed to add mesh : index out of range");
+			}
+			m_indices.push_back(remap[index]);
+		}
+		writeNewIndices(first);
+	}
+
+	/// <summary>
+	/// Add vertices in bulk from interleaved data, vertices are not welded
+	/// </summary>
+	/// <param name="vertices">Vertices</param>
+	/// <param name="vertexCount">Number of vertices</param>
+	/// <param name="indices">Triangle list indices into these vertices</param>
+	/// <param name="indexCount">Number of indices, multiple of 3</param>
+	void Vulkan::addVertices(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+	{
+		size_t firstVertex = m_vertices.size();
+		m_vertices.insert(m_vertices.end(), vertices, vertices + vertexCount);
+		appendIndices(firstVertex, indices, indexCount);
+	}
+
+	/// <summary>
+	/// Add vertices in bulk from separate position and color arrays, vertices are not welded
+	/// </summary>
+	/// <param name="positions">Positions</param>
+	/// <param name="colors">Colors</param>
+	/// <param name="vertexCount">Number of vertices</param>
+	/// <param name="indices">Triangle list indices into these vertices</param>
+	/// <param name="indexCount">Number of indices, multiple of 3</param>
+	void Vulkan::addVertices(const glm::vec3* positions, const glm::vec4* colors, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+	{
+		size_t firstVertex = m_vertices.size();
+		m_vertices.resize(firstVertex + vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+			m_vertices[firstVertex + i] = { positions[i], colors[i] };
+		appendIndices(firstVertex, indices, indexCount);
+	}
+
+	/// <summary>
+	/// Add vertices in bulk, vectors are moved in without copy when no geometry was added before
+	/// </summary>
+	/// <param name="vertices">Vertices</param>
+	/// <param name="indices">Triangle list indices into these vertices</param>
+	void Vulkan::addVertices(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices)
+	{
+		if (!m_vertices.empty() || !m_indices.empty()) {
+			addVertices(vertices.data(), vertices.size(), indices.data(), indices.size());
+			return;
+		}
+
+		if (indices.size() % 3 != 0)
+			throw std::runtime_error("Failed to add vertices : index count is not a multiple of 3");
+		for (uint32_t index : indices) {
+			if (index >= vertices.size())
+				throw std::runtime_error("Failed to add vertices : index out of range");
+		}
+
+		m_vertices = std::move(vertices);
+		m_indices = std::move(indices);
+		writeNewVertices(0);
+		writeNewIndices(0);
+	}
+
+	/// <summary>
+	/// Append indices of vertices added in bulk, vertices are removed again on invalid indices
+	/// </summary>
+	/// <param name="firstVertex">First vertex of the bulk</param>
+	/// <param name="indices">Indices relative to the first vertex</param>
+	/// <param name="indexCount">Number of indices</param>
+	void Vulkan::appendIndices(size_t firstVertex, const uint32_t* indices, size_t indexCount)
+	{
+		size_t vertexCount = m_vertices.size() - firstVertex;
+		if (indexCount % 3 != 0) {
+			m_vertices.resize(firstVertex);
+			throw std::runtime_error("Failed to add vertices : index count is not a multiple of 3");
+		}
+
+		size_t first = m_indices.size();
+		m_indices.resize(first + indexCount);
+		for (size_t i = 0; i < indexCount; i++) {
+			if (indices[i] >= vertexCount) {
+				m_vertices.resize(firstVertex);
+				m_indices.resize(first);
+				throw std::runtime_error("Failed to add vertices : index out of range");
+			}
+			m_indices[first + i] = static_cast<uint32_t>(firstVertex) + indices[i];
+		}
+
+		writeNewVertices(firstVertex);
+		writeNewIndices(first);
+	}
+
+	/// <summary>
+	/// Add a static mesh : producers write vertices and indices straight into the mapped staging ring
+	/// Static meshes have their own buffers, no CPU copy, and can't be edited
+	/// </summary>
+	/// <param name="vertexCount">Number of vertices</param>
+	/// <param name="indexCount">Number of 32 bits indices, multiple of 3</param>
+	/// <param name="bounds">Dequantization bounds of the mesh, identity for the float format</param>
+	/// <param name="vertexWriter">Writes vertices [first, first + count) in the current vertex format</param>
+	/// <param name="indexWriter">Writes indices [first, first + count) as uint32_t</param>
+	/// <param name="priority">MEMORY_PRIORITY_* : low priority meshes are refused over budget and evicted for higher priority resources</param>
+	/// <returns>Static mesh index, the mesh is drawn once its uploads are submitted</returns>
+	uint32_t Vulkan::addStaticMesh(size_t vertexCount, size_t indexCount, const VertexBounds& bounds, const UploadWriter& vertexWriter, const UploadWriter& indexWriter, int priority)
+	{
+		if (vertexCount == 0 || indexCount == 0 || indexCount % 3 != 0)
+			throw std::runtime_error("Failed to add static mesh : invalid vertex or index count");
+
+		StaticMesh mesh;
+		VkDeviceSize stride = VertexFormat::getStride(m_vertexFormat);
+		mesh.vertexBuffer = m_allocator->createBuffer(stride * vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh.vertexAllocation, MEMORY_CATEGORY_VERTEX, priority);
+		try {
+			mesh.indexBuffer = m_allocator->createBuffer(sizeof(uint32_t) * indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh.indexAllocation, MEMORY_CATEGORY_INDEX, priority);
+		}
+		catch (...) {
+			m_allocator->destroyBuffer(mesh.vertexBuffer, mesh.vertexAllocation);
+			throw;
+		}
+		mesh.indexCount = static_cast<uint32_t>(indexCount);
+		mesh.bounds = bounds;
+		mesh.priority = priority;
+		mesh.vertexHeap = m_allocator->getHeapIndex(mesh.vertexAllocation);
+		mesh.indexHeap = m_allocator->getHeapIndex(mesh.indexAllocation);
+
+		m_uploadManager->uploadWith(mesh.vertexBuffer, 0, stride, vertexCount, vertexWriter);
+		mesh.ticket = m_uploadManager->uploadWith(mesh.indexBuffer, 0, sizeof(uint32_t), indexCount, indexWriter);
+
+		m_staticMeshes.push_back(mesh);
+		return static_cast<uint32_t>(m_staticMeshes.size() - 1);
+	}
+
+	/// <summary>
+	/// Load a mesh file as static mesh : streams are copied from the file mapping to the staging ring
+	/// </summary>
+	/// <param name="filename">Mesh file written by MeshFile::write, in the current vertex format</param>
+	/// <param name="priority">MEMORY_PRIORITY_* of the mesh</param>
+	/// <returns>Static mesh index</returns>
+	uint32_t Vulkan::loadMesh(const std::string& filename, int priority)
+	{
+		MeshFile file(filename);
+		const MeshFileHeader& header = file.getHeader();
+		if (header.vertexFormat != m_vertexFormat)
+			throw std::runtime_error("Failed to load mesh " + filename + " : vertex format differs from the pipeline");
+
+		//Vertices as stored
+		const uint8_t* vertices = static_cast<const uint8_t*>(file.getVertexData());
+		size_t stride = header.vertexStride;
+		auto vertexWriter = [vertices, stride](void* dst, size_t first, size_t count) {
+			memcpy(dst, vertices + first * stride, count * stride);
+		};
+
+		//Indices out of range would read outside the vertex buffer : replaced by 0 while copying
+		const uint32_t* indices = file.getIndexData();
+		uint64_t vertexCount = header.vertexCount;
+		auto indexWriter = [indices, vertexCount](void* dst, size_t first, size_t count) {
+			uint32_t* out = static_cast<uint32_t*>(dst);
+			for (size_t i = 0; i < count; i++)
+				out[i] = indices[first + i] < vertexCount ? indices[first + i] : 0;
+		};
+
+		uint32_t mesh = addStaticMesh((size_t)header.vertexCount, (size_t)header.indexCount, header.bounds, vertexWriter, indexWriter, priority);
+		m_staticMeshes[mesh].lods.assign(file.getLods(), file.getLods() + header.lodCount);
+		return mesh;
+	}
+
+	/// <summary>
+	/// Select the drawn level of detail of a static mesh
+	/// </summary>
+	/// <param name="mesh">Static mesh index</param>
+	/// <param name="lod">LOD index, 0 is the finest</param>
+	void Vulkan::setStaticMeshLod(uint32_t mesh, uint32_t lod)
+	{
+		if (mesh >= m_staticMeshes.size() || (lod > 0 && lod >= m_staticMeshes[mesh].lods.size()))
+			throw std::runtime_error("Failed to set static mesh LOD : index out of range");
+
+		m_staticMeshes[mesh].lod = lod;
+	}
+
+	/// <summary>
+	/// Check if a static mesh is still in device memory
+	/// </summary>
+	/// <param name="mesh">Static mesh index</param>
+	/// <returns>false once evicted</returns>
+	bool Vulkan::isStaticMeshResident(uint32_t mesh) const
+	{
+		if (mesh >= m_staticMeshes.size())
+			throw std::runtime_error("Failed to get static mesh : index out of range");
+
+		return m_staticMeshes[mesh].vertexBuffer != VK_NULL_HANDLE;
+	}
+
+	/// <summary>
+	/// Get the upload ticket of a static mesh, to wait or poll its upload
+	/// </summary>
+	/// <param name="mesh">Static mesh index</param>
+	/// <returns>Ticket of the batch holding the last copy of the mesh</returns>
+	uint64_t Vulkan::getStaticMeshTicket(uint32_t mesh) const
+	{
+		if (mesh >= m_staticMeshes.size())
+			throw std::runtime_error("Failed to get static mesh : index out of range");
+
+		return m_staticMeshes[mesh].ticket;
+	}
+
+	/// <summary>
+	/// Release the buffers of a static mesh without waiting for the GPU, its index stays valid but it isn't drawn anymore
+	/// The buffers are destroyed once the frames submitted so far are done
+	/// </summary>
+	/// <param name="mesh">Static mesh index</param>
+	void Vulkan::unloadStaticMesh(uint32_t mesh)
+	{
+		if (mesh >= m_staticMeshes.size())
+			throw std::runtime_error("Failed to unload static mesh : index out of range");
+
+		StaticMesh& staticMesh = m_staticMeshes[mesh];
+		if (staticMesh.vertexBuffer == VK_NULL_HANDLE)
+			return;
+
+		//Copies to the buffers are not tracked by frames
+		m_uploadManager->wait(staticMesh.ticket);
+
+		m_deletionQueue->pushBuffer(staticMesh.vertexBuffer, staticMesh.vertexAllocation);
+		m_deletionQueue->pushBuffer(staticMesh.indexBuffer, staticMesh.indexAllocation);
+		staticMesh.vertexBuffer = VK_NULL_HANDLE;
+		staticMesh.indexBuffer = VK_NULL_HANDLE;
+	}
+
+	/// <summary>
+	/// Evict the largest static mesh of lower priority in a heap, its index stays valid but it isn't drawn anymore
+	/// Eviction callback of the allocator : buffers go to the deletion queue, freed once the frames submitted so far are done
+	/// Meshes with uploads in flight are kept
+	/// </summary>
+	/// <param name="heapIndex">Heap over budget</param>
+	/// <param name="priority">Priority of the resource being allocated</param>
+	/// <returns>Bytes of the heap scheduled for release, 0 if no mesh could be evicted</returns>
+	VkDeviceSize Vulkan::evictStaticMesh(uint32_t heapIndex, int priority)
+	{
+		StaticMesh* victim = nullptr;
+		for (StaticMesh& mesh : m_staticMeshes) {
+			if (mesh.vertexBuffer == VK_NULL_HANDLE || mesh.priority >= priority || !m_uploadManager->isComplete(mesh.ticket))
+				continue;
+			if (mesh.vertexHeap != heapIndex && mesh.indexHeap != heapIndex)
+				continue;
+			if (victim == nullptr || mesh.vertexAllocation.size + mesh.indexAllocation.size > victim->vertexAllocation.size + victim->indexAllocation.size)
+				victim = &mesh;
+		}
+		if (victim == nullptr)
+			return 0;
+
+		//Only the part in the heap over budget counts
+		VkDeviceSize released = 0;
+		if (victim->vertexHeap == heapIndex)
+			released += victim->vertexAllocation.size;
+		if (victim->indexHeap == heapIndex)
+			released += victim->indexAllocation.size;
+
+		//Destroyed with the current frame : no wait, the allocator is not called back
+		m_deletionQueue->pushBuffer(victim->vertexBuffer, victim->vertexAllocation);
+		m_deletionQueue->pushBuffer(victim->indexBuffer, victim->indexAllocation);
+		victim->vertexBuffer = VK_NULL_HANDLE;
+		victim->indexBuffer = VK_NULL_HANDLE;
+
+		std::cout << "Loukoum : static mesh " << (victim - m_staticMeshes.data()) << " evicted from memory heap " << heapIndex << std::endl;
+		return released;
+	}
+
+	/// <summary>
+	/// Replace a vertex, only this vertex is uploaded
+	/// Normals of compressed formats are not recomputed
+	/// </summary>
+	/// <param name="index">Vertex index</param>
+	/// <param name="vertex">New vertex</param>
+	void Vulkan::updateVertex(uint32_t index, const Vertex& vertex)
+	{
+		if (index >= m_vertices.size())
+			throw std::runtime_error("Failed to update vertex : index out of range");
+
+		//Keep welding lookup on the new value
+		if (index < m_vertexLookupSize) {
+			auto it = m_vertexLookup.find(m_vertices[index]);
+			if (it != m_vertexLookup.end() && it->second == index)
+				m_vertexLookup.erase(it);
+			m_vertexLookup.emplace(vertex, index);
+		}
+		m_vertices[index] = vertex;
+
+		if (m_vertexBuffer != nullptr)
+			writeVertices(index, 1);
+	}
+
+	/// <summary>
+	/// Remove a triangle, the last triangle takes its place
+	/// Its vertices are kept for other triangles
+	/// </summary>
+	/// <param name="triangle">Triangle index</param>
+	void Vulkan::removeTriangle(uint32_t triangle)
+	{
+		if (m_indices.size() % 3 != 0)
+			throw std::runtime_error("Failed to remove triangle : last triangle is incomplete");
+
+		size_t triangleCount = m_indices.size() / 3;
+		if (triangle >= triangleCount)
+			throw std::runtime_error("Failed to remove triangle : index out of range");
+
+		if (m_vertexBuffer != nullptr && m_vertexFormat != VERTEX_FORMAT_FLOAT)
+			addTriangleNormal(triangle, -1.0f);
+
+		//Swap with last triangle
+		size_t last = triangleCount - 1;
+		if (triangle != last)
+			std::copy(m_indices.begin() + last * 3, m_indices.begin() + last * 3 + 3, m_indices.begin() + triangle * 3);
+		m_indices.resize(last * 3);
+
+		if (m_vertexBuffer == nullptr)
+			return;
+
+		if (triangle != last)
+			writeIndices(triangle * 3, 3);
+		m_indexBuffer->resize(m_indices.size() * (m_indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)));
+	}
+
+	/// <summary>
+	/// Set vertex format, must be called before createVertexBuffer
+	/// The pipeline uses it from the next swapchain recreation
+	/// </summary>
+	/// <param name="format">VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_HALF or VERTEX_FORMAT_SNORM16</param>
+	void Vulkan::setVertexFormat(int format)
+	{
+		if (m_vertexBuffer != nullptr || !m_staticMeshes.empty())
+			throw std::runtime_error("Failed to set vertex format : vertex buffers already created");
+		//Throws on unknown format
+		VertexFormat::getStride(format);
+		m_vertexFormat = format;
+	}
+
+	/// <summary>
+	/// Find an identical vertex or append a new one
+	/// </summary>
+	/// <param name="vertex"></param>
+	/// <returns>Index of the vertex</returns>
+	uint32_t Vulkan::weldVertex(const Vertex& vertex)
+	{
+		//Vertices added in bulk are hashed on first weld only
+		for (; m_vertexLookupSize < m_vertices.size(); m_vertexLookupSize++)
+			m_vertexLookup.emplace(m_vertices[m_vertexLookupSize], static_cast<uint32_t>(m_vertexLookupSize));
+
+		auto it = m_vertexLookup.find(vertex);
+		if (it != m_vertexLookup.end())
+			return it->second;
+
+		uint32_t index = static_cast<uint32_t>(m_vertices.size());
+		m_vertices.push_back(vertex);
+		m_vertexLookup.emplace(vertex, index);
+		m_vertexLookupSize++;
+		writeNewVertices(index);
+
+		return index;
+	}
+
+	/// <summary>
+	/// Vertices appended : upload them if geometry is already on GPU
+	/// </summary>
+	/// <param name="first">First new vertex</param>
+	void Vulkan::writeNewVertices(size_t first)
+	{
+		if (m_vertexBuffer == nullptr)
+			return;
+
+		if (m_vertexFormat != VERTEX_FORMAT_FLOAT)
+			m_vertexNormals.resize(m_vertices.size(), glm::vec3(0.0f));
+		writeVertices(first, m_vertices.size() - first);
+	}
+
+	/// <summary>
+	/// Recreate Swapchain : only swapchain images, views and framebuffers depend on the window size
+	/// Frames in flight keep running, the old objects go to the deletion queue
+	/// Render pass and pipeline are rebuilt when the surface format changes
 	/// </summary>
 	void Vulkan::recreateSwapChain()
 	{
@@ -200,14 +857,139 @@ namespace Loukoum
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(m_logicalDevice);
+		auto start = std::chrono::steady_clock::now();
 
+		//The old swapchain is given to the new one, then destroyed with its views and framebuffers
+		VkFormat previousFormat = m_swapChainImageFormat;
+		cleanUpSwapChain();
 		createSwapchain();
+
 		createImageViews();
-		createRenderPass();
-		createPipeline();
+		if (m_renderPass == VK_NULL_HANDLE || m_swapChainImageFormat != previousFormat) {
+			cleanUpPipeline();
+			createRenderPass();
+			createPipeline();
+			warmUpPipelines();
+		}
 		createFramebuffers();
-		createCommandBuffers();
+
+		//Image count may change, fences of frames in flight are still waited by frame
+		m_imagesInFlight.assign(m_swapChainImages.size(), VK_NULL_HANDLE);
+		m_imageTimelineValues.assign(m_swapChainImages.size(), 0);
+
+		//Resize latency
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		m_resizeStats.count++;
+		m_resizeStats.lastTime = milliseconds;
+		m_resizeStats.totalTime += milliseconds;
+		m_resizeStats.maxTime = std::max(m_resizeStats.maxTime, milliseconds);
+	}
+
+	/// <summary>
+	/// Print swapchain recreation latency in the console
+	/// </summary>
+	void Vulkan::printResizeStats()
+	{
+		std::cout << std::endl;
+		std::cout << "Swapchain Recreation" << std::endl;
+		std::cout << "--Count : " << m_resizeStats.count << std::endl;
+		if (m_resizeStats.count > 0) {
+			std::cout << "--Last : " << m_resizeStats.lastTime << " ms" << std::endl;
+			std::cout << "--Average : " << m_resizeStats.totalTime / m_resizeStats.count << " ms" << std::endl;
+			std::cout << "--Max : " << m_resizeStats.maxTime << " ms" << std::endl;
+		}
+		std::cout << std::endl;
+	}
+
+	/// <summary>
+	/// Set frames in flight, present mode and swapchain image count, applied at the start of the next frame
+	/// The swapchain is recreated if needed, frames in flight are drained once if their count changes
+	/// </summary>
+	/// <param name="pacing"></param>
+	void Vulkan::setFramePacing(const FramePacing& pacing)
+	{
+		if (pacing.framesInFlight < 1 || pacing.framesInFlight > (uint32_t)MAX_FRAMES_IN_FLIGHT)
+			throw std::runtime_error("Failed to set frame pacing : frames in flight must be between 1 and MAX_FRAMES_IN_FLIGHT");
+
+		m_pendingFramePacing = pacing;
+		m_framePacingChanged = true;
+	}
+
+	/// <summary>
+	/// Get frame pacing policy in use
+	/// </summary>
+	/// <returns></returns>
+	const FramePacing& Vulkan::getFramePacing() const
+	{
+		return m_framePacing;
+	}
+
+	/// <summary>
+	/// Get latency and throughput measured since the frame pacing policy was set
+	/// </summary>
+	/// <returns></returns>
+	FramePacingStats Vulkan::getFramePacingStats() const
+	{
+		return m_framePacingStats;
+	}
+
+	/// <summary>
+	/// Print frame pacing policy, throughput and latency in the console
+	/// </summary>
+	void Vulkan::printFramePacingStats()
+	{
+		const char* presentModeName = "FIFO";
+		if (m_presentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+			presentModeName = "IMMEDIATE";
+		else if (m_presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+			presentModeName = "MAILBOX";
+		else if (m_presentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR)
+			presentModeName = "FIFO_RELAXED";
+
+		std::cout << std::endl;
+		std::cout << "Frame Pacing" << std::endl;
+		std::cout << "--Frames in flight : " << m_framePacing.framesInFlight << " | Present mode : " << presentModeName << " | Swapchain images : " << m_swapChainImages.size() << std::endl;
+		std::cout << "--Frames : " << m_framePacingStats.frameCount << std::endl;
+		if (m_framePacingStats.elapsedTime > 0.0)
+			std::cout << "--Throughput : " << m_framePacingStats.frameCount * 1000.0 / m_framePacingStats.elapsedTime << " FPS" << std::endl;
+		if (m_framePacingStats.latencyCount > 0) {
+			std::cout << "--Average latency : " << m_framePacingStats.totalLatency / m_framePacingStats.latencyCount << " ms" << std::endl;
+			std::cout << "--Max latency : " << m_framePacingStats.maxLatency << " ms" << std::endl;
+		}
+		std::cout << std::endl;
+	}
+
+	/// <summary>
+	/// Set the pipeline creation path, the pipeline is rebuilt on the new path while the current one is drawn
+	/// </summary>
+	/// <param name="path">PIPELINE_PATH_MONOLITHIC, PIPELINE_PATH_LIBRARY or PIPELINE_PATH_SHADER_OBJECT</param>
+	/// <returns>false if the path is not supported, monolithic pipelines are used</returns>
+	bool Vulkan::setPipelinePath(int path)
+	{
+		bool supported = m_pipelineManager->setPath(path);
+		if (!supported) {
+			std::cout << "Loukoum : pipeline path " << path << " not supported, monolithic pipelines used" << std::endl;
+			m_pipelineManager->setPath(PIPELINE_PATH_MONOLITHIC);
+		}
+
+		if (m_pipeline == 0 || m_pipelineManager->getPath(m_pipeline) == m_pipelineManager->getPath())
+			return supported;
+
+		//The current pipeline is drawn until the new one is created
+		if (m_fallbackPipeline != 0)
+			m_pipelineManager->release(m_fallbackPipeline);
+		m_fallbackPipeline = m_pipeline;
+		createPipeline();
+		return supported;
+	}
+
+	/// <summary>
+	/// Get path of the pipelines created from now on
+	/// </summary>
+	/// <returns></returns>
+	int Vulkan::getPipelinePath() const
+	{
+		return m_pipelineManager->getPath();
 	}
 
 	/// <summary>
@@ -234,6 +1016,15 @@ namespace Loukoum
 		return m_instance;
 	}
 
+	/// <summary>
+	/// Check if frames and uploads are synchronized with a timeline semaphore
+	/// </summary>
+	/// <returns></returns>
+	bool Vulkan::isTimelineEnabled() const
+	{
+		return m_timeline != nullptr;
+	}
+
 	/// <summary>
 	/// Set Frame Resized
 	/// </summary>
@@ -243,6 +1034,15 @@ namespace Loukoum
 		m_framebufferResized = b;
 	}
 
+	/// <summary>
+	/// Save the pipeline cache periodically, besides on shutdown
+	/// </summary>
+	/// <param name="seconds">Time between saves, 0 to disable</param>
+	void Vulkan::setPipelineCacheAutoSave(double seconds)
+	{
+		m_pipelineCache->setAutoSaveInterval(seconds);
+	}
+
 	/// <summary>
 	/// Check if the chosen validation layer are supported
 	/// </summary>
@@ -286,6 +1086,12 @@ namespace Loukoum
 			throw std::runtime_error("Validation layer activated but not supported");
 		}
 
+		//Vulkan 1.2 when the loader has it : memory budget queries (1.1) and timeline semaphores (1.2)
+		m_apiVersion = VK_API_VERSION_1_0;
+		auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+		if (enumerateInstanceVersion != nullptr && enumerateInstanceVersion(&m_apiVersion) == VK_SUCCESS)
+			m_apiVersion = std::min(m_apiVersion, (uint32_t)VK_API_VERSION_1_2);
+
 		//App info
 		VkApplicationInfo appInfo{};
 		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -293,7 +1099,7 @@ namespace Loukoum
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = m_apiVersion;
 
 		//Create info
 		VkInstanceCreateInfo createInfo{};
@@ -454,6 +1260,24 @@ namespace Loukoum
 			}
 		}
 
+		//Transfer family : transfer only family, else async compute family (both can copy without graphics)
+		for (int i = 0; i < queueFamilies.size(); i++)
+		{
+			VkQueueFlags flags = queueFamilies[i].queueFlags;
+			if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+				continue;
+
+			if (!indices.transferFamily.has_value() || !(flags & VK_QUEUE_COMPUTE_BIT))
+				indices.transferFamily = i;
+		}
+
+		//No transfer family : second queue of graphics family if any, else graphics queue
+		if (!indices.transferFamily.has_value() && indices.graphicsFamily.has_value())
+		{
+			indices.transferFamily = indices.graphicsFamily;
+			indices.transferQueueIndex = queueFamilies[indices.graphicsFamily.value()].queueCount > 1 ? 1 : 0;
+		}
+
 		return indices;
 	}
 
@@ -491,6 +1315,26 @@ namespace Loukoum
 		return true;
 	}
 
+	/// <summary>
+	/// Check if GPU supports an optional extension
+	/// </summary>
+	/// <param name="device"></param>
+	/// <param name="extension">Extension name</param>
+	/// <returns></returns>
+	bool Vulkan::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension)
+	{
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+		for (const auto& ext : availableExtensions) {
+			if (strcmp(extension, ext.extensionName) == 0)
+				return true;
+		}
+		return false;
+	}
+
 	/// <summary>
 	/// Create Logical Device
 	/// </summary>
@@ -501,15 +1345,16 @@ namespace Loukoum
 
 		//Create device queue info
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value() };
 
-		float queuePriority = 1.0f;
+		//Second graphics queue used for uploads has a lower priority than rendering
+		float queuePriorities[] = { 1.0f, 0.5f };
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
 			VkDeviceQueueCreateInfo queueCreateInfo{};
 			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 			queueCreateInfo.queueFamilyIndex = queueFamily;
-			queueCreateInfo.queueCount = 1;
-			queueCreateInfo.pQueuePriorities = &queuePriority;
+			queueCreateInfo.queueCount = queueFamily == indices.transferFamily.value() ? indices.transferQueueIndex + 1 : 1;
+			queueCreateInfo.pQueuePriorities = queuePriorities;
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
@@ -527,9 +1372,81 @@ namespace Loukoum
 		//Link features
 		createInfo.pEnabledFeatures = &deviceFeatures;
 
+		//Optional extensions : memory budget needs Vulkan 1.1 on instance and device
+		std::vector<const char*> enabledExtensions = deviceExtensions;
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_physicalDevice, &deviceProperties);
+		m_memoryBudgetSupported = m_apiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1 && isDeviceExtensionAvailable(m_physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (m_memoryBudgetSupported)
+			enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		//Optional timeline semaphores : core in Vulkan 1.2, the feature must be enabled
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		if (m_timelineRequested && m_apiVersion >= VK_API_VERSION_1_2 && deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+		{
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &timelineFeatures;
+			vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features);
+			m_timelineSupported = timelineFeatures.timelineSemaphore == VK_TRUE;
+		}
+
+		//Optional features are enabled through one pNext chain
+		void* featureChain = nullptr;
+		if (m_timelineSupported) {
+			timelineFeatures.pNext = featureChain;
+			featureChain = &timelineFeatures;
+		}
+		bool features2Supported = m_apiVersion >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1;
+
+		//Optional graphics pipeline library : pipelines linked from parts compiled once
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures{};
+		libraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+		if (features2Supported && isDeviceExtensionAvailable(m_physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)
+			&& isDeviceExtensionAvailable(m_physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+		{
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &libraryFeatures;
+			vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features);
+			m_pipelineLibrarySupported = libraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+		}
+		if (m_pipelineLibrarySupported) {
+			enabledExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+			enabledExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+			libraryFeatures.pNext = featureChain;
+			featureChain = &libraryFeatures;
+		}
+
+		//Optional shader objects : draw in dynamic rendering, whose dependencies are core in Vulkan 1.2
+		VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures{};
+		shaderObjectFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT;
+		VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+		dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+		if (m_apiVersion >= VK_API_VERSION_1_2 && deviceProperties.apiVersion >= VK_API_VERSION_1_2
+			&& isDeviceExtensionAvailable(m_physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)
+			&& isDeviceExtensionAvailable(m_physicalDevice, VK_EXT_SHADER_OBJECT_EXTENSION_NAME))
+		{
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &shaderObjectFeatures;
+			shaderObjectFeatures.pNext = &dynamicRenderingFeatures;
+			vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features);
+			m_shaderObjectSupported = shaderObjectFeatures.shaderObject == VK_TRUE && dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+		}
+		if (m_shaderObjectSupported) {
+			enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+			enabledExtensions.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+			dynamicRenderingFeatures.pNext = featureChain;
+			shaderObjectFeatures.pNext = &dynamicRenderingFeatures;
+			featureChain = &shaderObjectFeatures;
+		}
+		createInfo.pNext = featureChain;
+
 		//Extension enabled
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 		//Validation layers
 		if (enableValidationLayers) {
@@ -548,6 +1465,15 @@ namespace Loukoum
 		//Get Graphics and present Queue
 		vkGetDeviceQueue(m_logicalDevice, indices.graphicsFamily.value(), 0, &m_graphicsQueue);
 		vkGetDeviceQueue(m_logicalDevice, indices.presentFamily.value(), 0, &m_presentQueue);
+
+		//Get Transfer Queue
+		vkGetDeviceQueue(m_logicalDevice, indices.transferFamily.value(), indices.transferQueueIndex, &m_transferQueue);
+
+		if (m_shaderObjectSupported) {
+			m_cmdBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(m_logicalDevice, "vkCmdBeginRenderingKHR");
+			m_cmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(m_logicalDevice, "vkCmdEndRenderingKHR");
+			m_shaderObjectSupported = m_cmdBeginRendering != nullptr && m_cmdEndRendering != nullptr;
+		}
 	}
 
 	/// <summary>
@@ -561,8 +1487,10 @@ namespace Loukoum
 		VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
 		VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-		//Swapchain image count
+		//Swapchain image count : frame pacing one, or one more than the minimum
 		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+		if (m_framePacing.swapchainImageCount > 0)
+			imageCount = std::max(m_framePacing.swapchainImageCount, swapChainSupport.capabilities.minImageCount);
 
 		//Swapchain max image count, 0 means no limit
 		if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
@@ -600,22 +1528,25 @@ namespace Loukoum
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
 
-		//Manage old swap chain
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		//Old swap chain : its resources can be reused, its images stay valid for frames in flight
+		createInfo.oldSwapchain = m_swapChain;
 
 		//Create swap chain
-		if (vkCreateSwapchainKHR(m_logicalDevice, &createInfo, nullptr, &m_swapChain) != VK_SUCCESS) {
+		VkSwapchainKHR swapChain;
+		if (vkCreateSwapchainKHR(m_logicalDevice, &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create Swapchain");
 		}
+		m_swapChain = swapChain;
 
 		//Get swapchain images
 		vkGetSwapchainImagesKHR(m_logicalDevice, m_swapChain, &imageCount, nullptr);
 		m_swapChainImages.resize(imageCount);
 		vkGetSwapchainImagesKHR(m_logicalDevice, m_swapChain, &imageCount, m_swapChainImages.data());
 		
-		//Swapchain format and extent
+		//Swapchain format, extent and present mode
 		m_swapChainImageFormat = surfaceFormat.format;
 		m_swapChainExtent = extent;
+		m_presentMode = presentMode;
 	}
 
 	/// <summary>
@@ -666,14 +1597,14 @@ namespace Loukoum
 	}
 
 	/// <summary>
-	/// Choose best swapchain present mode
+	/// Choose swapchain present mode : the frame pacing one, FIFO is always available
 	/// </summary>
 	/// <param name="availablePresentModes">Present modes availables</param>
 	/// <returns></returns>
 	VkPresentModeKHR Vulkan::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 	{
 		for (const auto& availablePresentMode : availablePresentModes) {
-			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+			if (availablePresentMode == m_framePacing.presentMode) {
 				return availablePresentMode;
 			}
 		}
@@ -704,29 +1635,50 @@ namespace Loukoum
 	}
 
 	/// <summary>
-	/// Clean Up Swapchain
+	/// Clean Up Swapchain : size dependent objects go to the deletion queue
+	/// The swapchain handle stays valid until frames in flight are done, it can be given as oldSwapchain
 	/// </summary>
 	void Vulkan::cleanUpSwapChain()
 	{
 		for (auto framebuffer : m_swapChainFramebuffers) {
-			vkDestroyFramebuffer(m_logicalDevice, framebuffer, nullptr);
+			m_deletionQueue->pushFramebuffer(framebuffer);
 		}
-
-		vkFreeCommandBuffers(m_logicalDevice, m_commandPool, static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
-
-		vkDestroyPipeline(m_logicalDevice, m_graphicsPipeline, nullptr);
-		vkDestroyPipelineLayout(m_logicalDevice, m_pipelineLayout, nullptr);
-		vkDestroyRenderPass(m_logicalDevice, m_renderPass, nullptr);
+		m_swapChainFramebuffers.clear();
 
 		for (auto imageView : m_swapChainImageViews) {
-			vkDestroyImageView(m_logicalDevice, imageView, nullptr);
+			m_deletionQueue->pushImageView(imageView);
 		}
+		m_swapChainImageViews.clear();
 
-		for (VkShaderModule shader : m_shaderModules)
-			vkDestroyShaderModule(m_logicalDevice, shader, nullptr);
+		if (m_swapChain != VK_NULL_HANDLE)
+			m_deletionQueue->pushSwapchain(m_swapChain);
+	}
 
-		vkDestroySwapchainKHR(m_logicalDevice, m_swapChain, nullptr);
+	/// <summary>
+	/// Clean Up Pipeline : render pass and pipeline, kept across resizes, shaders stay in the library
+	/// </summary>
+	void Vulkan::cleanUpPipeline()
+	{
+		if (m_renderPass == VK_NULL_HANDLE)
+			return;
 
+		//Frames in flight use them
+		if (m_pipeline != 0) {
+			m_pipelineManager->release(m_pipeline);
+			m_pipeline = 0;
+		}
+		if (m_fallbackPipeline != 0) {
+			m_pipelineManager->release(m_fallbackPipeline);
+			m_fallbackPipeline = 0;
+		}
+		for (PipelineHandle handle : m_warmPipelines)
+			m_pipelineManager->release(handle);
+		m_warmPipelines.clear();
+		m_pipelineManager->clearLibraries();
+
+		//Released pipelines may still compile against it : the manager destroys it after them
+		m_pipelineManager->releaseRenderPass(m_renderPass);
+		m_renderPass = VK_NULL_HANDLE;
 	}
 
 	/// <summary>
@@ -763,45 +1715,6 @@ namespace Loukoum
 		}
 	}
 
-	/// <summary>
-	/// Create Shader Stage
-	/// </summary>
-	/// <param name="filename"></param>
-	/// <param name="type"></param>
-	/// <returns></returns>
-	VkPipelineShaderStageCreateInfo Vulkan::createShaderStage(std::string filename, int type)
-	{
-		//Read file
-		const std::vector<char>& code = Utils::readFileBytecode(filename);
-
-		//Create Info
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-		//Create Module
-		VkShaderModule shaderModule;
-		if (vkCreateShaderModule(m_logicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create shader module!");
-		}
-		m_shaderModules.push_back(shaderModule);
-
-		//Create stage
-		VkPipelineShaderStageCreateInfo shaderStageInfo{};
-		shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStageInfo.module = shaderModule;
-		shaderStageInfo.pName = "main";
-
-		if(type == SHADER_VERTEX)
-			shaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		else if(type == SHADER_FRAGMENT)
-			shaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		return shaderStageInfo;
-
-	}
-
 	/// <summary>
 	/// Create Render Pass
 	/// </summary>
@@ -860,151 +1773,154 @@ namespace Loukoum
 	}
 
 	/// <summary>
-	/// Create Pipeline
+	/// Create Pipeline : request the graphics pipeline, compiled in the background, draws wait for it
 	/// </summary>
 	void Vulkan::createPipeline()
 	{
-		//Test shader
-		VkPipelineShaderStageCreateInfo vert = createShaderStage("C:/Users/trist/Documents/VS_Project/Loukoum/x64/Debug/shaders/test.vert.spv", SHADER_VERTEX);
-		VkPipelineShaderStageCreateInfo frag = createShaderStage("C:/Users/trist/Documents/VS_Project/Loukoum/x64/Debug/shaders/test.frag.spv", SHADER_FRAGMENT);
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vert, frag };
-
-		//Vertex input
-		auto bindingDescription = Vertex::getBindingDescription();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-		//Input assembly : how vertices are linked
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-		//Viewport
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)m_swapChainExtent.width;
-		viewport.height = (float)m_swapChainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+		//Test shader, compiled on the first build then watched, rebuilds reuse the modules
+		if (m_vertexShader == 0) {
+			m_vertexShader = m_shaderLibrary->acquire(m_shaderCompiler->compile(m_vertexSource));
+			m_shaderCompiler->watch(m_vertexSource);
+		}
+		if (m_fragmentShader == 0) {
+			m_fragmentShader = m_shaderLibrary->acquire(m_shaderCompiler->compile(m_fragmentSource));
+			m_shaderCompiler->watch(m_fragmentSource);
+		}
 
-		//Scissor
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = m_swapChainExtent;
+		//Layout generated from the shaders : descriptors and push constants (vertex dequantization bounds)
+		PipelineLayoutInfo layoutInfo = m_layoutCache->getLayout({ m_shaderLibrary->getInterface(m_vertexShader), m_shaderLibrary->getInterface(m_fragmentShader) });
+
+		//Fixed-function state : pipeline manager defaults
+		PipelineDescription description;
+		description.vertexShader = m_vertexShader;
+		description.fragmentShader = m_fragmentShader;
+		description.vertexFormat = m_vertexFormat;
+		description.layout = layoutInfo.layout;
+		description.renderPass = m_renderPass;
+		description.subpass = 0;
+		description.pushConstantStages = layoutInfo.pushConstantStages;
+		description.pushConstantSize = layoutInfo.pushConstantSize;
+		m_pipeline = m_pipelineManager->request(description);
+		m_pipelineManifest->record(m_vertexSource, m_fragmentSource, description);
+	}
 
-		//Viewport state info (Viewport + scissor)
-		VkPipelineViewportStateCreateInfo viewportState{};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
-
-		//Rasterizer
-		VkPipelineRasterizationStateCreateInfo rasterizer{};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;
-		rasterizer.rasterizerDiscardEnable = VK_FALSE;;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-		rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-		rasterizer.depthBiasEnable = VK_FALSE;
-		rasterizer.depthBiasConstantFactor = 0.0f;
-		rasterizer.depthBiasClamp = 0.0f;
-		rasterizer.depthBiasSlopeFactor = 0.0f;
-
-		//Multisampling
-		VkPipelineMultisampleStateCreateInfo multisampling{};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		multisampling.minSampleShading = 1.0f;
-		multisampling.pSampleMask = nullptr;
-		multisampling.alphaToCoverageEnable = VK_FALSE;
-		multisampling.alphaToOneEnable = VK_FALSE;
-
-		//Color blend Attachment
-		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-		//Color blending
-		VkPipelineColorBlendStateCreateInfo colorBlending{};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY;
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f;
-		colorBlending.blendConstants[1] = 0.0f;
-		colorBlending.blendConstants[2] = 0.0f;
-		colorBlending.blendConstants[3] = 0.0f;
-
-		//Dynamic states
-		VkDynamicState dynamicStates[] = {
-			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_LINE_WIDTH
-		};
-		VkPipelineDynamicStateCreateInfo dynamicState{};
-		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		dynamicState.dynamicStateCount = 2;
-		dynamicState.pDynamicStates = dynamicStates;
-
-		//Pipeline layout
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 0;
-		pipelineLayoutInfo.pSetLayouts = nullptr;
-		pipelineLayoutInfo.pushConstantRangeCount = 0;
-		pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-		//Create Pipeline Layout
-		if (vkCreatePipelineLayout(m_logicalDevice, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create Pipeline layout");
-		}
-
-		//Create Pipeline
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = nullptr;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = nullptr;
-
-		//Link pipeline layout and render pas
-		pipelineInfo.layout = m_pipelineLayout;
-		pipelineInfo.renderPass = m_renderPass;
-		pipelineInfo.subpass = 0;
-
-		//No second pipeline
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-		pipelineInfo.basePipelineIndex = -1;
-
-		//Create pipeline
-		if (vkCreateGraphicsPipelines(m_logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create graphical pipeline");
+	/// <summary>
+	/// Warm-up : queue the pipelines of the manifest for the current render pass and layout, before the first frame
+	/// Shaders are compiled or read from the shader cache in parallel, then pipelines are compiled by the pipeline manager without waiting
+	/// A stale entry (source removed, constant or interface changed) is skipped and dropped from the manifest
+	/// </summary>
+	void Vulkan::warmUpPipelines()
+	{
+		//Copy : the manifest may record while waiting
+		std::vector<PipelineManifestEntry> entries = m_pipelineManifest->getEntries();
+		if (entries.empty())
+			return;
+
+		auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::vector<char>> vertexCode(entries.size());
+		std::vector<std::vector<char>> fragmentCode(entries.size());
+		m_threadPool->parallelFor(entries.size(), 1, [this, &entries, &vertexCode, &fragmentCode](size_t begin, size_t end, uint32_t) {
+			for (size_t i = begin; i < end; i++) {
+				try {
+					vertexCode[i] = m_shaderCompiler->compile(entries[i].vertexSource);
+					fragmentCode[i] = m_shaderCompiler->compile(entries[i].fragmentSource);
+				}
+				catch (const std::exception& error) {
+					std::cout << "Loukoum : pipeline warm-up skipped, " << error.what() << std::endl;
+					vertexCode[i].clear();
+				}
+			}
+		});
+
+		//Shaders are retained by the manager until their pipeline is compiled
+		size_t queued = 0;
+		for (size_t i = 0; i < entries.size(); i++) {
+			if (vertexCode[i].empty() || fragmentCode[i].empty()) {
+				m_pipelineManifest->remove(entries[i]);
+				continue;
+			}
+
+			PipelineDescription description = entries[i].description;
+			description.vertexShader = 0;
+			description.fragmentShader = 0;
+			try {
+				description.vertexShader = m_shaderLibrary->acquire(vertexCode[i]);
+				description.fragmentShader = m_shaderLibrary->acquire(fragmentCode[i]);
+				PipelineLayoutInfo layoutInfo = m_layoutCache->getLayout({ m_shaderLibrary->getInterface(description.vertexShader), m_shaderLibrary->getInterface(description.fragmentShader) });
+				description.layout = layoutInfo.layout;
+				description.pushConstantStages = layoutInfo.pushConstantStages;
+				description.pushConstantSize = layoutInfo.pushConstantSize;
+				description.renderPass = m_renderPass;
+				m_warmPipelines.push_back(m_pipelineManager->request(description));
+				queued++;
+			}
+			catch (const std::exception& error) {
+				std::cout << "Loukoum : pipeline warm-up skipped, " << error.what() << std::endl;
+				m_pipelineManifest->remove(entries[i]);
+			}
+			if (description.vertexShader != 0)
+				m_shaderLibrary->release(description.vertexShader);
+			if (description.fragmentShader != 0)
+				m_shaderLibrary->release(description.fragmentShader);
 		}
+
+		//Pipelines keep compiling on the manager workers, frames never wait for them
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Loukoum : " << queued << " pipelines queued for warm-up in " << milliseconds << " ms" << std::endl;
+	}
+
+	/// <summary>
+	/// Hot reload : swap the shaders compiled since last frame and rebuild the pipeline, called before recording
+	/// A shader failing to compile keeps its previous module
+	/// </summary>
+	void Vulkan::reloadShaders()
+	{
+		m_shaderCompiler->update();
+
+		bool changed = false;
+		for (const CompiledShader& shader : m_shaderCompiler->takeCompiled()) {
+			if (shader.code.empty()) {
+				std::cout << shader.error << std::endl;
+				continue;
+			}
+
+			ShaderHandle* handle = nullptr;
+			if (shader.source.filename == m_vertexSource.filename && shader.source.stage == m_vertexSource.stage)
+				handle = &m_vertexShader;
+			else if (shader.source.filename == m_fragmentSource.filename && shader.source.stage == m_fragmentSource.stage)
+				handle = &m_fragmentShader;
+			if (handle == nullptr)
+				continue;
+
+			//Code the reflection can't read : previous module kept
+			ShaderHandle reloaded;
+			try {
+				reloaded = m_shaderLibrary->acquire(shader.code);
+			}
+			catch (const std::exception& error) {
+				std::cout << "Loukoum : shader " << shader.source.filename << " not reloaded, " << error.what() << std::endl;
+				continue;
+			}
+
+			//Same code : saved without change
+			m_shaderLibrary->release(*handle);
+			if (reloaded == *handle)
+				continue;
+
+			*handle = reloaded;
+			changed = true;
+			std::cout << "Loukoum : shader " << shader.source.filename << " reloaded" << std::endl;
+		}
+
+		if (!changed)
+			return;
+
+		//The current pipeline is drawn until the new one is compiled
+		if (m_fallbackPipeline != 0)
+			m_pipelineManager->release(m_fallbackPipeline);
+		m_fallbackPipeline = m_pipeline;
+		createPipeline();
 	}
 
 	/// <summary>
@@ -1036,56 +1952,136 @@ namespace Loukoum
 	}
 
 	/// <summary>
-	/// Create Command Pool
+	/// Create Command Pools : per frame in flight, one for the primary command buffer and one per recording thread
 	/// </summary>
-	void Vulkan::createCommandPool()
+	void Vulkan::createCommandPools()
 	{
 		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(m_physicalDevice);
 		VkCommandPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
-		poolInfo.flags = 0;
-		if (vkCreateCommandPool(m_logicalDevice, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create Command Pool");
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		m_frameCommands.resize(MAX_FRAMES_IN_FLIGHT);
+		for (FrameCommands& frame : m_frameCommands)
+		{
+			if (vkCreateCommandPool(m_logicalDevice, &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create Command Pool");
+			}
+
+			//Primary command buffer, recorded again every frame
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = frame.commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(m_logicalDevice, &allocInfo, &frame.primary) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate command buffer!");
+			}
+
+			//A command pool can't be used by two threads at once
+			frame.workerPools.resize(m_threadPool->getWorkerCount());
+			frame.workerBuffers.resize(m_threadPool->getWorkerCount());
+			frame.workerBufferUsed.resize(m_threadPool->getWorkerCount(), 0);
+			for (VkCommandPool& pool : frame.workerPools) {
+				if (vkCreateCommandPool(m_logicalDevice, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create worker Command Pool");
+				}
+			}
 		}
 	}
 
 	/// <summary>
-	/// Create Command Buffers
+	/// Destroy Command Pools and their command buffers, GPU must be idle
 	/// </summary>
-	void Vulkan::createCommandBuffers()
+	void Vulkan::destroyCommandPools()
 	{
-		m_commandBuffers.resize(m_swapChainFramebuffers.size());
-
-		//Buffer allocation
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = m_commandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)m_commandBuffers.size();
+		for (FrameCommands& frame : m_frameCommands)
+		{
+			vkDestroyCommandPool(m_logicalDevice, frame.commandPool, nullptr);
+			for (VkCommandPool pool : frame.workerPools)
+				vkDestroyCommandPool(m_logicalDevice, pool, nullptr);
+		}
+		m_frameCommands.clear();
+	}
 
-		if (vkAllocateCommandBuffers(m_logicalDevice, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to allocate command buffer!");
+	/// <summary>
+	/// Record the current frame : scene draws are split in secondary command buffers recorded in parallel,
+	/// then executed in order by the primary command buffer
+	/// The frame fence must be signaled
+	/// </summary>
+	/// <param name="imageIndex">Swapchain image index</param>
+	void Vulkan::recordFrame(uint32_t imageIndex)
+	{
+		FrameCommands& frame = m_frameCommands[m_currentFrame];
+
+		//Everything recorded for this frame last time is done : reset pools as a whole
+		vkResetCommandPool(m_logicalDevice, frame.commandPool, 0);
+		for (VkCommandPool pool : frame.workerPools)
+			vkResetCommandPool(m_logicalDevice, pool, 0);
+		std::fill(frame.workerBufferUsed.begin(), frame.workerBufferUsed.end(), 0);
+
+		collectDraws();
+		frame.secondaries.assign((m_drawCommands.size() + DRAWS_PER_SECONDARY - 1) / DRAWS_PER_SECONDARY, VK_NULL_HANDLE);
+
+		//Secondary command buffers continue the render pass of the primary
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = m_renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = m_swapChainFramebuffers[imageIndex];
+
+		//Or its dynamic rendering, for shader objects
+		bool dynamicRendering = m_drawPath == PIPELINE_PATH_SHADER_OBJECT;
+		VkCommandBufferInheritanceRenderingInfo renderingInheritanceInfo{};
+		renderingInheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		renderingInheritanceInfo.colorAttachmentCount = 1;
+		renderingInheritanceInfo.pColorAttachmentFormats = &m_swapChainImageFormat;
+		renderingInheritanceInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		if (dynamicRendering) {
+			inheritanceInfo.pNext = &renderingInheritanceInfo;
+			inheritanceInfo.renderPass = VK_NULL_HANDLE;
+			inheritanceInfo.framebuffer = VK_NULL_HANDLE;
 		}
 
-		//Foreach command buffer
-		for (size_t i = 0; i < m_commandBuffers.size(); i++) {
+		m_threadPool->parallelFor(m_drawCommands.size(), DRAWS_PER_SECONDARY, [this, &frame, &inheritanceInfo](size_t begin, size_t end, uint32_t worker) {
+			VkCommandBuffer commandBuffer = getSecondaryCommandBuffer(frame, worker);
 
-			//Start recording of command buffer
 			VkCommandBufferBeginInfo beginInfo{};
 			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.flags = 0;
-			beginInfo.pInheritanceInfo = nullptr;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to start secondary command buffer recording");
+			}
+
+			recordDraws(commandBuffer, begin, end);
 
-			if (vkBeginCommandBuffer(m_commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-				throw std::runtime_error("Failed to start command buffer recording!");
+			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to end secondary command buffer recording");
 			}
+			frame.secondaries[begin / DRAWS_PER_SECONDARY] = commandBuffer;
+		});
+
+		//Start recording of the primary command buffer
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		if (vkBeginCommandBuffer(frame.primary, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to start command buffer recording!");
+		}
 
+		if (dynamicRendering) {
+			beginDynamicRendering(frame.primary, imageIndex);
+		}
+		else {
 			//Start a render pass info
 			VkRenderPassBeginInfo renderPassInfo{};
 			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 			renderPassInfo.renderPass = m_renderPass;
-			renderPassInfo.framebuffer = m_swapChainFramebuffers[i];
+			renderPassInfo.framebuffer = m_swapChainFramebuffers[imageIndex];
 			renderPassInfo.renderArea.offset = { 0, 0 };
 			renderPassInfo.renderArea.extent = m_swapChainExtent;
 
@@ -1094,23 +2090,220 @@ namespace Loukoum
 			renderPassInfo.clearValueCount = 1;
 			renderPassInfo.pClearValues = &clearColor;
 
-			//Begin Render pass
-			vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBeginRenderPass(frame.primary, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		}
+
+		//Render pass content comes from secondary command buffers
+		if (!frame.secondaries.empty())
+			vkCmdExecuteCommands(frame.primary, static_cast<uint32_t>(frame.secondaries.size()), frame.secondaries.data());
+
+		//Finish render
+		if (dynamicRendering)
+			endDynamicRendering(frame.primary, imageIndex);
+		else
+			vkCmdEndRenderPass(frame.primary);
+		if (vkEndCommandBuffer(frame.primary) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to end command buffer recording");
+		}
+	}
+
+	/// <summary>
+	/// Begin dynamic rendering on the swapchain image, same attachment as the render pass : cleared, then presented
+	/// </summary>
+	/// <param name="commandBuffer">Primary command buffer</param>
+	/// <param name="imageIndex">Swapchain image index</param>
+	void Vulkan::beginDynamicRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		//Layout transition done by the render pass otherwise
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_swapChainImages[imageIndex];
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkRenderingAttachmentInfo colorAttachment{};
+		colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		colorAttachment.imageView = m_swapChainImageViews[imageIndex];
+		colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.clearValue = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		VkRenderingInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+		renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+		renderingInfo.renderArea.offset = { 0, 0 };
+		renderingInfo.renderArea.extent = m_swapChainExtent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachments = &colorAttachment;
+		m_cmdBeginRendering(commandBuffer, &renderingInfo);
+	}
+
+	/// <summary>
+	/// End dynamic rendering and transition the swapchain image for presentation
+	/// </summary>
+	/// <param name="commandBuffer">Primary command buffer</param>
+	/// <param name="imageIndex">Swapchain image index</param>
+	void Vulkan::endDynamicRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		m_cmdEndRendering(commandBuffer);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_swapChainImages[imageIndex];
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
 
-			//Bind Pipeline and draw
-			vkCmdBindPipeline(m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
-			VkBuffer vertexBuffers[] = {m_vertexBuffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(m_commandBuffers[i], 0, 1, vertexBuffers, offsets);
-			vkCmdDraw(m_commandBuffers[i], static_cast<uint32_t>(m_vertices.size()), 1, 0, 0);
+	/// <summary>
+	/// Get a free secondary command buffer from the pool of a worker, allocated the first time
+	/// </summary>
+	/// <param name="frame">Frame being recorded</param>
+	/// <param name="worker">Worker index of the calling thread</param>
+	/// <returns></returns>
+	VkCommandBuffer Vulkan::getSecondaryCommandBuffer(FrameCommands& frame, uint32_t worker)
+	{
+		std::vector<VkCommandBuffer>& buffers = frame.workerBuffers[worker];
+		size_t& used = frame.workerBufferUsed[worker];
 
-			//Finish render
-			vkCmdEndRenderPass(m_commandBuffers[i]);
-			if (vkEndCommandBuffer(m_commandBuffers[i]) != VK_SUCCESS) {
-				throw std::runtime_error("Failed to end command buffer recording");
+		if (used == buffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = frame.workerPools[worker];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(m_logicalDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate secondary command buffer");
 			}
+			buffers.push_back(commandBuffer);
 		}
 
+		return buffers[used++];
+	}
+
+	/// <summary>
+	/// Gather the draws of the scene : dynamic geometry, then resident static meshes
+	/// </summary>
+	void Vulkan::collectDraws()
+	{
+		m_drawCommands.clear();
+		m_drawPath = PIPELINE_PATH_MONOLITHIC;
+
+		//Pipeline still compiling : previous one, or nothing drawn
+		PipelineHandle pipeline = m_pipeline;
+		bool ready = m_pipelineManager->isReady(pipeline);
+		if (ready && m_fallbackPipeline != 0) {
+			m_pipelineManager->release(m_fallbackPipeline);
+			m_fallbackPipeline = 0;
+		}
+		else if (!ready && m_fallbackPipeline != 0) {
+			pipeline = m_fallbackPipeline;
+			ready = m_pipelineManager->isReady(pipeline);
+		}
+		if (!ready)
+			return;
+		m_drawPath = m_pipelineManager->getPath(pipeline);
+
+		//Bounds are pushed when the vertex shader declares them
+		PipelineDescription description = m_pipelineManager->getDescription(pipeline);
+		VkShaderStageFlags pushConstantStages = description.pushConstantSize >= sizeof(VertexBounds) ? description.pushConstantStages : 0;
+
+		if (m_vertexBuffer != nullptr && m_indices.size() >= 3) {
+			DrawCommand draw;
+			draw.pipeline = pipeline;
+			draw.layout = description.layout;
+			draw.pushConstantStages = pushConstantStages;
+			draw.vertexBuffer = m_vertexBuffer->getBuffer();
+			draw.indexBuffer = m_indexBuffer->getBuffer();
+			draw.indexType = m_indexType;
+			draw.indexCount = static_cast<uint32_t>(m_indices.size() / 3 * 3);
+			draw.firstIndex = 0;
+			draw.bounds = m_vertexBounds;
+			m_drawCommands.push_back(draw);
+		}
+
+		for (const StaticMesh& mesh : m_staticMeshes) {
+			if (mesh.vertexBuffer == VK_NULL_HANDLE)
+				continue;
+
+			DrawCommand draw;
+			draw.pipeline = pipeline;
+			draw.layout = description.layout;
+			draw.pushConstantStages = pushConstantStages;
+			draw.vertexBuffer = mesh.vertexBuffer;
+			draw.indexBuffer = mesh.indexBuffer;
+			draw.indexType = VK_INDEX_TYPE_UINT32;
+			draw.indexCount = mesh.lods.empty() ? mesh.indexCount : mesh.lods[mesh.lod].indexCount;
+			draw.firstIndex = mesh.lods.empty() ? 0 : mesh.lods[mesh.lod].firstIndex;
+			draw.bounds = mesh.bounds;
+			m_drawCommands.push_back(draw);
+		}
+	}
+
+	/// <summary>
+	/// Record draws [begin, end) in a command buffer inside the render pass, pipelines and buffers are bound when they change
+	/// Called from worker threads : only reads the draw list
+	/// </summary>
+	/// <param name="commandBuffer"></param>
+	/// <param name="begin">First draw</param>
+	/// <param name="end">Draw after the last one</param>
+	void Vulkan::recordDraws(VkCommandBuffer commandBuffer, size_t begin, size_t end)
+	{
+		//Dynamic states aren't inherited by secondary command buffers
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float)m_swapChainExtent.width;
+		viewport.height = (float)m_swapChainExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = m_swapChainExtent;
+
+		PipelineHandle boundPipeline = 0;
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+		for (size_t i = begin; i < end; i++) {
+			const DrawCommand& draw = m_drawCommands[i];
+			if (draw.pipeline != boundPipeline) {
+				m_pipelineManager->bind(commandBuffer, draw.pipeline, viewport, scissor);
+				boundPipeline = draw.pipeline;
+			}
+			if (draw.vertexBuffer != boundVertexBuffer) {
+				VkDeviceSize offsets[] = { 0 };
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.vertexBuffer, offsets);
+				boundVertexBuffer = draw.vertexBuffer;
+			}
+			if (draw.indexBuffer != boundIndexBuffer) {
+				vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, draw.indexType);
+				boundIndexBuffer = draw.indexBuffer;
+			}
+			if (draw.pushConstantStages != 0)
+				vkCmdPushConstants(commandBuffer, draw.layout, draw.pushConstantStages, 0, sizeof(VertexBounds), &draw.bounds);
+			vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, 0, 0);
+		}
 	}
 
 	/// <summary>
@@ -1118,11 +2311,13 @@ namespace Loukoum
 	/// </summary>
 	void Vulkan::createSyncObjects()
 	{
-		//Resize semaphores and fences
+		//Resize semaphores and fences, the timeline replaces fences
 		m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 		m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		m_inFlightFences.resize(m_timeline != nullptr ? 0 : MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
 		m_imagesInFlight.resize(m_swapChainImages.size(), VK_NULL_HANDLE);
+		m_frameTimelineValues.assign(MAX_FRAMES_IN_FLIGHT, 0);
+		m_imageTimelineValues.assign(m_swapChainImages.size(), 0);
 
 		//Info
 		VkSemaphoreCreateInfo semaphoreInfo{};
@@ -1136,33 +2331,87 @@ namespace Loukoum
 		{
 			if (vkCreateSemaphore(m_logicalDevice, &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
 				vkCreateSemaphore(m_logicalDevice, &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-				vkCreateFence(m_logicalDevice, &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
+				(m_timeline == nullptr && vkCreateFence(m_logicalDevice, &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS))
 			{
 
 				throw std::runtime_error("Failed to create sync objects (semaphores and fences)");
 			}
 		}
+
+		//Frame latency measures
+		m_frameStartTimes.resize(MAX_FRAMES_IN_FLIGHT);
+		m_frameMeasured.assign(MAX_FRAMES_IN_FLIGHT, true);
+		m_framePacingStart = std::chrono::steady_clock::now();
 	}
 
 	/// <summary>
-	/// Find suitable memory type for memory allocation
+	/// Apply the frame pacing policy set since the last frame, the measures of the previous one are printed
 	/// </summary>
-	/// <param name="typeFilter"></param>
-	/// <param name="properties"></param>
-	/// <returns></returns>
-	uint32_t Vulkan::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	void Vulkan::applyFramePacing()
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProperties);
+		measureFrameLatency();
+		printFramePacingStats();
+
+		bool swapChainChanged = m_pendingFramePacing.presentMode != m_framePacing.presentMode || m_pendingFramePacing.swapchainImageCount != m_framePacing.swapchainImageCount;
+		if (m_pendingFramePacing.framesInFlight != m_framePacing.framesInFlight) {
+			//Frame slots are used in a new order : drain them once
+			m_deletionQueue->collect(waitFramesInFlight());
+			m_currentFrame = 0;
+		}
 
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-				return i;
-			}
+		m_framePacing = m_pendingFramePacing;
+		m_framePacingChanged = false;
+		if (swapChainChanged)
+			recreateSwapChain();
+
+		//Measures start over
+		m_framePacingStats = FramePacingStats();
+		m_frameMeasured.assign(MAX_FRAMES_IN_FLIGHT, true);
+		m_framePacingStart = std::chrono::steady_clock::now();
+	}
+
+	/// <summary>
+	/// Measure latency of frames the GPU finished since the last call, never blocks
+	/// </summary>
+	void Vulkan::measureFrameLatency()
+	{
+		auto now = std::chrono::steady_clock::now();
+		uint64_t completed = m_timeline != nullptr ? m_timeline->getCompletedValue() : 0;
+
+		for (uint32_t i = 0; i < m_framePacing.framesInFlight; i++)
+		{
+			if (m_frameMeasured[i])
+				continue;
+
+			bool done = m_timeline != nullptr ? completed >= m_frameTimelineValues[i] : vkGetFenceStatus(m_logicalDevice, m_inFlightFences[i]) == VK_SUCCESS;
+			if (!done)
+				continue;
+
+			double latency = std::chrono::duration<double, std::milli>(now - m_frameStartTimes[i]).count();
+			m_framePacingStats.latencyCount++;
+			m_framePacingStats.totalLatency += latency;
+			m_framePacingStats.maxLatency = std::max(m_framePacingStats.maxLatency, latency);
+			m_frameMeasured[i] = true;
 		}
 
-		throw std::runtime_error("Failed to find suitable memory type!");
+		m_framePacingStats.elapsedTime = std::chrono::duration<double, std::milli>(now - m_framePacingStart).count();
+	}
+
+	/// <summary>
+	/// Block until every frame and upload submitted to the graphics queue is done
+	/// </summary>
+	/// <returns>Value to collect the deletion queue with</returns>
+	uint64_t Vulkan::waitFramesInFlight()
+	{
+		if (m_timeline != nullptr) {
+			uint64_t submitted = m_timeline->getLastSubmitted();
+			m_timeline->wait(submitted);
+			return submitted;
+		}
 
+		if (!m_inFlightFences.empty())
+			vkWaitForFences(m_logicalDevice, static_cast<uint32_t>(m_inFlightFences.size()), m_inFlightFences.data(), VK_TRUE, UINT64_MAX);
+		return m_frameNumber;
 	}
 
 	//////////////////////////////////////////////////////////////////////////////
@@ -9,12 +9,30 @@
 #include <optional>
 #include <set>
 #include <array>
+#include <unordered_map>
+#include <chrono>
+#include <deque>
+#include <mutex>
 
 #include <glm/glm.hpp>
 
 //#include "Shader.h"
 
 #include "Utils.h"
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "VertexFormat.h"
+#include "MeshOptimizer.h"
+#include "GeometryBuffer.h"
+#include "MeshFile.h"
+#include "ThreadPool.h"
+#include "DeletionQueue.h"
+#include "Timeline.h"
+#include "PipelineCache.h"
+#include "ShaderLibrary.h"
+#include "ShaderCompiler.h"
+#include "PipelineManager.h"
+#include "PipelineManifest.h"
 
 namespace Loukoum
 {
@@ -24,10 +42,8 @@ namespace Loukoum
 		constexpr bool enableValidationLayers = true;
 	#endif
 
-	const int MAX_FRAMES_IN_FLIGHT = 2;
-
-	constexpr int SHADER_VERTEX = 0;
-	constexpr int SHADER_FRAGMENT = 1;
+	//Frame slots created, the frame pacing policy uses 1 to MAX_FRAMES_IN_FLIGHT of them
+	const int MAX_FRAMES_IN_FLIGHT = 4;
 
 	/// <summary>
 	/// Queue Family indices
@@ -36,6 +52,10 @@ namespace Loukoum
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
 
+		//Uploads : dedicated transfer family, else second graphics queue, else graphics queue itself
+		std::optional<uint32_t> transferFamily;
+		uint32_t transferQueueIndex = 0;
+
 		bool isComplete() {
 			return graphicsFamily.has_value() && presentFamily.has_value();
 		}
@@ -51,38 +71,93 @@ namespace Loukoum
 	};
 
 	/// <summary>
-	/// Vertex structure
+	/// Geometry without CPU copy, filled through the staging ring
 	/// </summary>
-	struct Vertex {
-		glm::vec3 pos;
-		glm::vec4 color;
+	struct StaticMesh {
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		Allocation vertexAllocation;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		Allocation indexAllocation;
+		uint32_t indexCount = 0;
+		VertexBounds bounds;
+
+		//Ranges of the index buffer, the drawn one is lod
+		std::vector<MeshFileLod> lods;
+		uint32_t lod = 0;
+
+		//Eviction : buffers are destroyed for higher priority resources once the upload is done
+		//Heaps are kept so the eviction callback doesn't query the allocator
+		int priority = MEMORY_PRIORITY_NORMAL;
+		uint64_t ticket = 0;
+		uint32_t vertexHeap = 0;
+		uint32_t indexHeap = 0;
+	};
 
-		static VkVertexInputBindingDescription getBindingDescription() {
-			VkVertexInputBindingDescription bindingDescription{};
-			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(Vertex);
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-			return bindingDescription;
+	/// <summary>
+	/// Swapchain recreation latency, in milliseconds
+	/// </summary>
+	struct ResizeStats {
+		uint32_t count = 0;
+		double lastTime = 0.0;
+		double totalTime = 0.0;
+		double maxTime = 0.0;
+	};
 
-		}
+	/// <summary>
+	/// Frame pacing policy : fewer frames and images lower latency, more of them raise throughput
+	/// </summary>
+	struct FramePacing {
+		//Frames recorded ahead of the GPU, 1 to MAX_FRAMES_IN_FLIGHT
+		uint32_t framesInFlight = 2;
 
-		static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-			std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+		//Preferred present mode, FIFO when not supported
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
 
-			//Position
-			attributeDescriptions[0].binding = 0;
-			attributeDescriptions[0].location = 0;
-			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[0].offset = offsetof(Vertex, pos);
+		//Swapchain images, 0 for minimum + 1, clamped to the surface limits
+		uint32_t swapchainImageCount = 0;
+	};
 
-			//Color
-			attributeDescriptions[1].binding = 0;
-			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-			attributeDescriptions[1].offset = offsetof(Vertex, color);
+	/// <summary>
+	/// Frames measured since the frame pacing policy was set
+	/// Latency goes from the start of drawFrame to the GPU completion of the frame, seen once per frame
+	/// </summary>
+	struct FramePacingStats {
+		uint64_t frameCount = 0;
+		double elapsedTime = 0.0;
+		uint64_t latencyCount = 0;
+		double totalLatency = 0.0;
+		double maxLatency = 0.0;
+	};
 
-			return attributeDescriptions;
-		}
+	/// <summary>
+	/// One indexed draw of the scene
+	/// </summary>
+	struct DrawCommand {
+		PipelineHandle pipeline;
+		VkPipelineLayout layout;
+		VkShaderStageFlags pushConstantStages;	//0 when the shader has no bounds push constant
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		VkIndexType indexType;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		VertexBounds bounds;
+	};
+
+	/// <summary>
+	/// Command pools of a frame in flight, reset as a whole once the frame fence is signaled
+	/// </summary>
+	struct FrameCommands {
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkCommandBuffer primary = VK_NULL_HANDLE;
+
+		//One pool per recording thread, secondary command buffers are kept from frame to frame
+		std::vector<VkCommandPool> workerPools;
+		std::vector<std::vector<VkCommandBuffer>> workerBuffers;
+		std::vector<size_t> workerBufferUsed;
+
+		//Secondary command buffers of the frame, in draw order
+		std::vector<VkCommandBuffer> secondaries;
 	};
 
 	/// <summary>
@@ -107,30 +182,63 @@ namespace Loukoum
 	class Vulkan
 	{
 	public:
-		Vulkan(GLFWwindow* window);
+		Vulkan(GLFWwindow* window, bool timelineSemaphores = true);
 		~Vulkan();
 
 		//GPU
 		void printGPUsData();
+		void printMemoryStats();
 
 		//Draw Frame
 		void drawFrame();
 
-		//Vertex methods
+		//Vertex methods : every three vertices make a triangle, identical vertices are welded
 		void createVertexBuffer();
 		void addVertex(glm::vec3 pos, glm::vec4 color);
+		void addTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+		void addMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		void setVertexFormat(int format);
+
+		//Bulk ingest
+		void addVertices(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+		void addVertices(const glm::vec3* positions, const glm::vec4* colors, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+		void addVertices(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices);
+		uint32_t addStaticMesh(size_t vertexCount, size_t indexCount, const VertexBounds& bounds, const UploadWriter& vertexWriter, const UploadWriter& indexWriter, int priority = MEMORY_PRIORITY_NORMAL);
+		uint32_t loadMesh(const std::string& filename, int priority = MEMORY_PRIORITY_NORMAL);
+		void setStaticMeshLod(uint32_t mesh, uint32_t lod);
+		bool isStaticMeshResident(uint32_t mesh) const;
+		uint64_t getStaticMeshTicket(uint32_t mesh) const;
+		void unloadStaticMesh(uint32_t mesh);
+
+		//Geometry edits after createVertexBuffer, uploaded with the next frame
+		void updateVertex(uint32_t index, const Vertex& vertex);
+		void removeTriangle(uint32_t triangle);
 
 		//Recreate Swapchain
 		void recreateSwapChain();
+		void printResizeStats();
+
+		//Frame pacing : applied at the start of the next frame, without restart
+		void setFramePacing(const FramePacing& pacing);
+		const FramePacing& getFramePacing() const;
+		FramePacingStats getFramePacingStats() const;
+		void printFramePacingStats();
+
+		//Pipeline creation path : PIPELINE_PATH_MONOLITHIC, PIPELINE_PATH_LIBRARY or PIPELINE_PATH_SHADER_OBJECT
+		//Unsupported paths fall back to monolithic, the pipeline is rebuilt while the previous one is drawn
+		bool setPipelinePath(int path);
+		int getPipelinePath() const;
 
 		//Create Shader
 		//Shader* createShader(std::string vertexFilename, std::string fragmentFilename);
 
 		//Getters
 		VkInstance getInstance() const;
+		bool isTimelineEnabled() const;
 
 		//Setters
 		void setFrameResized(bool b);
+		void setPipelineCacheAutoSave(double seconds);
 
 	private:
 
@@ -145,12 +253,14 @@ namespace Loukoum
 		void rateGPUs(std::vector<VkPhysicalDevice> devices);
 		QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+		bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension);
 		void createLogicalDevice();
 
 		//Instance and surface
 		VkInstance m_instance;
 		VkSurfaceKHR m_surface;
 		GLFWwindow* m_window;
+		uint32_t m_apiVersion;
 
 		//GPU
 		std::vector<GPU*> m_allGPU;
@@ -158,6 +268,16 @@ namespace Loukoum
 		VkDevice m_logicalDevice;
 		VkQueue m_graphicsQueue;
 		VkQueue m_presentQueue;
+		VkQueue m_transferQueue;
+
+		//Queues are externally synchronized : held around every submission and present, uploads submit from any thread
+		std::mutex m_queueMutex;
+
+		bool m_memoryBudgetSupported = false;
+		bool m_timelineRequested = true;
+		bool m_timelineSupported = false;
+		bool m_pipelineLibrarySupported = false;
+		bool m_shaderObjectSupported = false;
 		const std::vector<const char*> deviceExtensions = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
@@ -171,11 +291,14 @@ namespace Loukoum
 
 		//Swapchain recreation
 		void cleanUpSwapChain();
+		void cleanUpPipeline();
+		ResizeStats m_resizeStats;
 
 		//Swapchain variables
-		VkSwapchainKHR m_swapChain;
+		VkSwapchainKHR m_swapChain = VK_NULL_HANDLE;
 		std::vector<VkImage> m_swapChainImages;
-		VkFormat m_swapChainImageFormat;
+		VkFormat m_swapChainImageFormat = VK_FORMAT_UNDEFINED;
+		VkPresentModeKHR m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
 		VkExtent2D m_swapChainExtent;
 
 		//Image view
@@ -183,28 +306,55 @@ namespace Loukoum
 		std::vector<VkImageView> m_swapChainImageViews;
 
 		//Shaders
-		VkPipelineShaderStageCreateInfo createShaderStage(std::string filename, int type);
 		//std::vector<Shader*> m_shaders;
-		std::vector<VkShaderModule> m_shaderModules;
+		ShaderLibrary* m_shaderLibrary = nullptr;
+		PipelineLayoutCache* m_layoutCache = nullptr;
+		ShaderCompiler* m_shaderCompiler = nullptr;
+		ShaderSource m_vertexSource{ "test.vert", VK_SHADER_STAGE_VERTEX_BIT, {} };
+		ShaderSource m_fragmentSource{ "test.frag", VK_SHADER_STAGE_FRAGMENT_BIT, {} };
+		ShaderHandle m_vertexShader = 0;
+		ShaderHandle m_fragmentShader = 0;
+		void reloadShaders();
 
 		//Render pass
-		VkRenderPass m_renderPass;
+		VkRenderPass m_renderPass = VK_NULL_HANDLE;
 		void createRenderPass();
 
-		//Pipeline
+		//Pipeline : compiled by the manager, the fallback is drawn while a rebuild compiles
 		void createPipeline();
-		VkPipeline m_graphicsPipeline;
-		VkPipelineLayout m_pipelineLayout;
+		PipelineManager* m_pipelineManager = nullptr;
+		PipelineHandle m_pipeline = 0;
+		PipelineHandle m_fallbackPipeline = 0;
+
+		//Warm-up : pipelines of the previous runs, created while loading
+		void warmUpPipelines();
+		PipelineManifest* m_pipelineManifest = nullptr;
+		std::vector<PipelineHandle> m_warmPipelines;
+
+		//Shader objects draw in dynamic rendering instead of the render pass : path of the pipeline drawn this frame
+		int m_drawPath = PIPELINE_PATH_MONOLITHIC;
+		PFN_vkCmdBeginRenderingKHR m_cmdBeginRendering = nullptr;
+		PFN_vkCmdEndRenderingKHR m_cmdEndRendering = nullptr;
 
 		//Framebuffers
 		void createFramebuffers();
 		std::vector<VkFramebuffer> m_swapChainFramebuffers;
 
-		//Command Pool and buffers
-		void createCommandPool();
-		void createCommandBuffers();
-		VkCommandPool m_commandPool;
-		std::vector<VkCommandBuffer> m_commandBuffers;
+		//Command Pools and buffers : the scene is recorded every frame by the thread pool
+		void createCommandPools();
+		void destroyCommandPools();
+		void recordFrame(uint32_t imageIndex);
+		void beginDynamicRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void endDynamicRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		VkCommandBuffer getSecondaryCommandBuffer(FrameCommands& frame, uint32_t worker);
+		void collectDraws();
+		void recordDraws(VkCommandBuffer commandBuffer, size_t begin, size_t end);
+		std::vector<FrameCommands> m_frameCommands;
+		std::vector<DrawCommand> m_drawCommands;
+		ThreadPool* m_threadPool = nullptr;
+
+		//Draws per secondary command buffer, smaller chunks balance threads better but cost more binds
+		static constexpr size_t DRAWS_PER_SECONDARY = 256;
 
 		//Semaphores and Fences : to render
 		void createSyncObjects();
@@ -212,14 +362,67 @@ namespace Loukoum
 		std::vector<VkSemaphore> m_renderFinishedSemaphores;
 		std::vector<VkFence> m_inFlightFences;
 		std::vector<VkFence> m_imagesInFlight;
+
+		//Frame pacing
+		void applyFramePacing();
+		void measureFrameLatency();
+		uint64_t waitFramesInFlight();
+		FramePacing m_framePacing;
+		FramePacing m_pendingFramePacing;
+		bool m_framePacingChanged = false;
+		FramePacingStats m_framePacingStats;
+		std::chrono::steady_clock::time_point m_framePacingStart;
+		std::vector<std::chrono::steady_clock::time_point> m_frameStartTimes;
+		std::vector<bool> m_frameMeasured;
+
+		//Timeline mode : one graphics timeline, values signaled by the last frame of each slot and image
+		Timeline* m_timeline = nullptr;
+		std::vector<uint64_t> m_frameTimelineValues;
+		std::vector<uint64_t> m_imageTimelineValues;
 		size_t m_currentFrame = 0;
+		uint64_t m_frameNumber = 0;
 		bool m_framebufferResized = false;
 
-		//Vertex Methods and Variables
-		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
-		VkBuffer m_vertexBuffer;
-		VkDeviceMemory m_vertexBufferMemory;
+		//Device memory and uploads
+		MemoryAllocator* m_allocator;
+		UploadManager* m_uploadManager;
+
+		//Resources destroyed once the frames submitted before their release are done
+		DeletionQueue* m_deletionQueue;
+
+		//Pipeline cache kept on disk, shared by all pipelines
+		PipelineCache* m_pipelineCache = nullptr;
+
+		//Vertex Variables
+		uint32_t weldVertex(const Vertex& vertex);
+		void optimizeGeometry();
+		void updateGeometry();
+		void writeVertices(size_t first, size_t count);
+		void writeNewVertices(size_t first);
+		void repackVertices();
+		GeometryBuffer* m_vertexBuffer = nullptr;
 		std::vector<Vertex> m_vertices;
+		std::unordered_map<Vertex, uint32_t, VertexHash> m_vertexLookup;
+		size_t m_vertexLookupSize = 0;
+		int m_vertexFormat = VERTEX_FORMAT_FLOAT;
+		VertexBounds m_vertexBounds;
+
+		//Compressed formats : area weighted normals, kept up to date as triangles are added and removed
+		std::vector<glm::vec3> m_vertexNormals;
+		bool m_repackVertices = false;
+
+		//Index Variables : 16 bits indices while vertex count allows it
+		void writeIndices(size_t first, size_t count);
+		void writeNewIndices(size_t first);
+		void appendIndices(size_t firstVertex, const uint32_t* indices, size_t indexCount);
+		void addTriangleNormal(size_t triangle, float sign);
+		GeometryBuffer* m_indexBuffer = nullptr;
+		VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+		std::vector<uint32_t> m_indices;
+
+		//Static meshes
+		VkDeviceSize evictStaticMesh(uint32_t heapIndex, int priority);
+		std::vector<StaticMesh> m_staticMeshes;
 
 		//Validation Layers
 		const std::vector<const char*> validationLayers = {"VK_LAYER_KHRONOS_validation"};
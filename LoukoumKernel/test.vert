@@ -4,21 +4,19 @@ out gl_PerVertex {
     vec4 gl_Position;
 };
 
-layout(location = 0) out vec3 fragColor;
+//Vertex attributes : float, half or snorm16 positions (see VertexFormat)
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inColor;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+//Dequantization bounds : position = offset + scale * stored position
+layout(push_constant) uniform VertexBounds {
+    vec4 offset;
+    vec4 scale;
+} bounds;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    gl_Position = vec4(bounds.offset.xyz + bounds.scale.xyz * inPosition.xyz, 1.0);
+    fragColor = inColor.rgb;
 }
\ No newline at end of file
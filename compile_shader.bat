@@ -1 +0,0 @@
-C:/VulkanSDK/1.2.176.1/Bin32/glslc.exe %1 -o %1%.spv
\ No newline at end of file